@@ -0,0 +1,280 @@
+/**
+ * @file    component_index.hpp
+ * @brief   valid-pairs index built independently per weakly connected component
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_COMPONENT_INDEX_HPP
+#define PAIRG_COMPONENT_INDEX_HPP
+
+#include <numeric>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+#include "reachability.hpp"
+#include "row_sweep.hpp"
+#include "utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     valid-pairs index of a graph made of several weakly connected
+   *            components, e.g., one per chromosome
+   * @details   - no valid pair crosses components, so each component is an
+   *              independent diagonal block of the index
+   *            - components are grouped into blocks of at least blockVertices
+   *              vertices (small components would not fill the threads), blocks
+   *              are built one after another, so the intermediate powers of
+   *              only one block are held at a time; see blockVerticesFor to
+   *              size blocks to a memory budget
+   *            - vertex ids are mapped to (block, local id), local ids keep the
+   *              global order, so rows stay sorted and an acyclic block stays
+   *              upper triangular
+   *            - queries across components are answered false without a lookup
+   */
+  class componentIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+
+      //count of vertices
+      lno_t numRows = 0;
+
+      //count of weakly connected components
+      lno_t numComponents = 0;
+
+      //valid-pairs pattern per block, in local ids
+      std::vector<matrixOps::graph_t> blocks;
+
+      /**
+       * @brief                     build index
+       * @param[in] A               sparsity pattern of graph adjacency matrix
+       * @param[in] p               input parameters (distance constraints)
+       * @param[in] blockVertices   minimum count of vertices per block
+       */
+      void build(const matrixOps::graph_t &A, const Parameters &p, lno_t blockVertices = 1 << 16)
+      {
+        numRows = A.numRows();
+
+        pairg::timer T1;
+        labelComponents(A);
+
+        //group components into blocks, in order of their first vertex
+        blockOf.assign(numComponents, 0);
+        std::vector<lno_t> size (numComponents, 0);
+        for(lno_t v = 0; v < numRows; v++)
+          size[component[v]]++;
+
+        lno_t blockCount = 0, filled = 0;
+        for(lno_t c = 0; c < numComponents; c++)
+        {
+          if (filled >= blockVertices)
+          {
+            blockCount++;
+            filled = 0;
+          }
+          blockOf[c] = blockCount;
+          filled += size[c];
+        }
+        if (numComponents > 0)
+          blockCount++;
+
+        //local ids in global order
+        std::vector< std::vector<lno_t> > members (blockCount);
+        local.resize(numRows);
+        for(lno_t v = 0; v < numRows; v++)
+        {
+          auto &m = members[blockOf[component[v]]];
+          local[v] = m.size();
+          m.push_back(v);
+        }
+        std::cout << "INFO, pairg::componentIndex::build, components = " << numComponents << ", blocks = " << blockCount << ", time (ms): " << T1.elapsed() << "\n";
+
+        blocks.clear();
+        for(lno_t b = 0; b < blockCount; b++)
+        {
+          pairg::timer T2;
+          matrixOps::graph_t sub = extractBlock(A, members[b]);
+          blocks.push_back(buildValidPairsGraph(sub, p));
+          std::cout << "INFO, pairg::componentIndex::build, block " << b << " with " << members[b].size() << " vertices, time (ms): " << T2.elapsed() << "\n";
+        }
+
+        vertexOf = std::move(members);
+      }
+
+      /**
+       * @brief                 count of vertices per block so that building one block
+       *                        stays within a memory budget
+       * @param[in] budget      memory budget (bytes) for one block build
+       * @details               valid pairs per vertex are estimated from an evenly
+       *                        spaced sample of rows (rowSweep); a build holds about
+       *                        three patterns of that size (two factors and their
+       *                        product). A component larger than the result still
+       *                        gets a block of its own
+       */
+      static lno_t blockVerticesFor(const matrixOps::graph_t &A, const Parameters &p, std::size_t budget, lno_t samples = 256)
+      {
+        lno_t n = A.numRows();
+        rowSweep sweep (n);
+        std::vector<lno_t> cols;
+        double entries = 0;
+        lno_t sampled = 0;
+
+        for(lno_t k = 0; k < samples && n > 0; k++, sampled++)
+        {
+          sweep.compute(A, (lno_t) ((int64_t) k * n / samples), p.d_low, p.d_up, cols);
+          entries += cols.size();
+        }
+
+        double bytesPerVertex = 3 * (entries / std::max<lno_t>(sampled, 1) * sizeof(lno_t) + sizeof(size_type));
+        lno_t blockVertices = (lno_t) std::min<double>(std::max(budget / bytesPerVertex, 1.0), n > 0 ? n : 1);
+
+        std::cout << "INFO, pairg::componentIndex::blockVerticesFor, estimated bytes per vertex = " << bytesPerVertex << ", block vertices = " << blockVertices << "\n";
+        return blockVertices;
+      }
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        if (i >= numRows || j >= numRows) {
+          std::cout << "WARNING, pairg::componentIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        if (component[i] != component[j])
+          return false;
+
+        return matrixOps::queryValue(blocks[blockOf[component[i]]], local[i], local[j]);
+      }
+
+      /**
+       * @brief                 move the index into one pattern of the whole graph, in global ids
+       * @return                pattern with sorted rows, same as a single build on the whole graph
+       * @details               blocks are copied and freed one at a time, so the peak is
+       *                        the global pattern plus one block; the index is empty afterwards
+       */
+      matrixOps::graph_t toGlobal()
+      {
+        matrixOps::lno_view_t row_map ("row_map", numRows + 1);
+        Kokkos::parallel_for("pairg::componentIndex::toGlobal::count", matrixOps::range_type(0, numRows), [&](const lno_t v)
+        {
+          const matrixOps::graph_t &B = blocks[blockOf[component[v]]];
+          row_map(v + 1) = B.row_map(local[v] + 1) - B.row_map(local[v]);
+        });
+
+        size_type nnz = matrixOps::prefixSum(row_map);
+        matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+        for(std::size_t b = 0; b < blocks.size(); b++)
+        {
+          const matrixOps::graph_t &B = blocks[b];
+          const std::vector<lno_t> &vertices = vertexOf[b];
+
+          Kokkos::parallel_for("pairg::componentIndex::toGlobal::fill", matrixOps::range_type(0, (lno_t) vertices.size()), [&](const lno_t r)
+          {
+            size_type out = row_map(vertices[r]);
+
+            for(size_type k = B.row_map(r); k < B.row_map(r + 1); k++)
+              entries(out++) = vertices[B.entries(k)];
+          });
+
+          blocks[b] = matrixOps::graph_t();
+          std::vector<lno_t>().swap(vertexOf[b]);
+        }
+
+        *this = componentIndex();
+
+        return matrixOps::graph_t(entries, row_map);
+      }
+
+      /**
+       * @brief                 print index size to stdout
+       */
+      void printStats() const
+      {
+        size_type nnz = 0;
+        for(auto &B : blocks)
+          nnz += B.entries.extent(0);
+
+        std::cout << "INFO, pairg::componentIndex::printStats, blocks = " << blocks.size() << ", nnz = " << nnz << "\n";
+      }
+
+    private:
+
+      //per vertex
+      std::vector<lno_t> component, local;
+
+      //per component
+      std::vector<lno_t> blockOf;
+
+      //per block, global id of each local id
+      std::vector< std::vector<lno_t> > vertexOf;
+
+      /**
+       * @brief                 label weakly connected components by union-find,
+       *                        numbered in order of their lowest vertex id
+       */
+      void labelComponents(const matrixOps::graph_t &A)
+      {
+        std::vector<lno_t> parent (numRows);
+        std::iota(parent.begin(), parent.end(), 0);
+
+        auto find = [&](lno_t v)
+        {
+          while (parent[v] != v)
+            v = parent[v] = parent[parent[v]];
+          return v;
+        };
+
+        for(lno_t u = 0; u < numRows; u++)
+          for(size_type k = A.row_map(u); k < A.row_map(u+1); k++)
+          {
+            lno_t a = find(u), b = find(A.entries(k));
+            if (a != b)
+              parent[std::max(a, b)] = std::min(a, b);
+          }
+
+        component.assign(numRows, -1);
+        numComponents = 0;
+
+        for(lno_t v = 0; v < numRows; v++)
+        {
+          lno_t r = find(v);
+          if (component[r] < 0)
+            component[r] = numComponents++;
+          component[v] = component[r];
+        }
+      }
+
+      /**
+       * @brief                 adjacency pattern among the given vertices, in local ids
+       */
+      matrixOps::graph_t extractBlock(const matrixOps::graph_t &A, const std::vector<lno_t> &vertices) const
+      {
+        lno_t n = vertices.size();
+
+        matrixOps::lno_view_t row_map ("row_map", n + 1);
+        for(lno_t r = 0; r < n; r++)
+          row_map(r + 1) = A.row_map(vertices[r] + 1) - A.row_map(vertices[r]);
+
+        size_type nnz = matrixOps::prefixSum(row_map);
+        matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+        Kokkos::parallel_for("pairg::componentIndex::extractBlock", matrixOps::range_type(0, n), [&](const lno_t r)
+        {
+          size_type out = row_map(r);
+          for(size_type k = A.row_map(vertices[r]); k < A.row_map(vertices[r] + 1); k++)
+            entries(out++) = local[A.entries(k)];
+        });
+
+        return matrixOps::graph_t(entries, row_map);
+      }
+  };
+}
+
+#endif
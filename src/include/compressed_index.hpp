@@ -0,0 +1,329 @@
+/**
+ * @file    compressed_index.hpp
+ * @brief   valid-pairs index with delta + varint compressed rows
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_COMPRESSED_INDEX_HPP
+#define PAIRG_COMPRESSED_INDEX_HPP
+
+#include "spgemm_utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     valid-pairs index where the sorted columns of each row are
+   *            stored as byte-aligned deltas
+   * @details   - each row is cut into blocks of up to blockSize columns; the
+   *              first column of each block is stored uncompressed (skip
+   *              pointer) along with the byte offset of the block
+   *            - within a block, gaps between consecutive columns are stored
+   *              in StreamVByte layout: one control byte per group of 4 gaps
+   *              (2 bits per gap = byte length - 1), followed by the gap bytes,
+   *              i.e., control and data streams are separated so that a group
+   *              can be decoded with a single byte shuffle
+   *            - queries binary-search the skip pointers of a row and decode a
+   *              single block
+   *            - build using build() from a row-sorted sparsity pattern, or
+   *              directly from the factors C * D of the pattern
+   */
+  class compressedIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      typedef Kokkos::View<uint8_t*, matrixOps::Device> byte_view_t;
+
+      //count of columns per block
+      static const int blockSize = 64;
+
+      //columns of row i: [row_map(i), row_map(i+1)), blocks of row i: [block_map(i), block_map(i+1))
+      matrixOps::lno_view_t row_map;
+      matrixOps::lno_view_t block_map;
+
+      //first column and byte range of each block, block b spans [block_offset(b), block_offset(b+1))
+      matrixOps::lno_nnz_view_t block_first;
+      matrixOps::lno_view_t block_offset;
+
+      //encoded gaps
+      byte_view_t data;
+
+      //count of rows, count of columns
+      lno_t numRows, numCols;
+
+      compressedIndex() : numRows(0), numCols(0) {}
+
+      /**
+       * @brief                 build index from a sparsity pattern
+       * @param[in]   G         valid-pairs pattern, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       * @param[in]   numCols   count of columns, if it differs from the count of rows
+       */
+      void build(const matrixOps::graph_t &G, lno_t numCols)
+      {
+        assemble(G.numRows(), numCols, patternRows(G));
+      }
+
+      void build(const matrixOps::graph_t &G)
+      {
+        build(G, G.numRows());
+      }
+
+      /**
+       * @brief                 build index directly from the factors of the
+       *                        valid-pairs pattern C * D
+       * @details               rows of the product are computed twice (count
+       *                        and encode pass), only encoded blocks are stored
+       */
+      void build(const matrixOps::graph_t &C, const matrixOps::graph_t &D)
+      {
+        assemble(C.numRows(), C.numRows(), productRows(C, D));
+      }
+
+      /**
+       * @brief                 build index from a matrix
+       * @param[in]   A         valid-pairs matrix, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::crsMat_t &A)
+      {
+        build(A.graph);
+      }
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        if (i >= numRows || j >= numCols) {
+          std::cout << "WARNING, pairg::compressedIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        const lno_t *begin = block_first.data() + block_map(i);
+        const lno_t *end = block_first.data() + block_map(i + 1);
+
+        //last block starting at or before j
+        const lno_t *it = std::upper_bound(begin, end, j);
+        if (it == begin)
+          return false;
+
+        size_type b = (it - 1) - block_first.data();
+        lno_t cols[blockSize];
+        size_type n = blockLength(i, b);
+        decodeBlock(data.data() + block_offset(b), block_first(b), n, cols);
+
+        return std::binary_search(cols, cols + n, j);
+      }
+
+      /**
+       * @brief                 decode all columns of a row
+       */
+      void decodeRow(lno_t i, std::vector<lno_t> &cols) const
+      {
+        cols.resize(row_map(i+1) - row_map(i));
+
+        for(size_type b = block_map(i); b < block_map(i+1); b++)
+          decodeBlock(data.data() + block_offset(b), block_first(b), blockLength(i, b), cols.data() + (b - block_map(i)) * blockSize);
+      }
+
+      /**
+       * @brief                 total size (in bytes) of index arrays
+       */
+      std::size_t memoryBytes() const
+      {
+        return (row_map.extent(0) + block_map.extent(0) + block_offset.extent(0)) * sizeof(size_type)
+          + block_first.extent(0) * sizeof(lno_t)
+          + data.extent(0) * sizeof(uint8_t);
+      }
+
+      /**
+       * @brief                 print index properties to stdout
+       */
+      void printStats() const
+      {
+        std::cout << "INFO, pairg::compressedIndex::printStats, rows:" << numRows << ", entries:" << row_map(numRows) << ", blocks:" << block_first.extent(0) << "\n";
+        std::cout << "INFO, pairg::compressedIndex::printStats, encoded bytes:" << data.extent(0) << ", size (bytes):" << memoryBytes() << "\n";
+      }
+
+    private:
+
+      /**
+       * @brief                 sorted rows of a pattern, visited as (i, cols, n)
+       */
+      struct patternRows
+      {
+        const matrixOps::graph_t &G;
+
+        patternRows(const matrixOps::graph_t &G_) : G(G_) {}
+
+        template <typename VisitFn>
+          void operator() (const VisitFn &visit, const std::string &label) const
+          {
+            Kokkos::parallel_for(label, range_type(0, G.numRows()), [&](const lno_t i)
+            {
+              visit(i, G.entries.data() + G.row_map(i), G.row_map(i+1) - G.row_map(i));
+            });
+          }
+      };
+
+      /**
+       * @brief                 sorted rows of the product C * D, visited as (i, cols, n)
+       */
+      struct productRows
+      {
+        const matrixOps::graph_t &C;
+        const matrixOps::graph_t &D;
+
+        productRows(const matrixOps::graph_t &C_, const matrixOps::graph_t &D_) : C(C_), D(D_) {}
+
+        template <typename VisitFn>
+          void operator() (const VisitFn &visit, const std::string &label) const
+          {
+            matrixOps::forEachProductRow(C, D, [&](const lno_t i, const std::vector<lno_t> &cols)
+            {
+              visit(i, cols.data(), cols.size());
+            }, label);
+          }
+      };
+
+      /**
+       * @brief                 build index in two passes over the rows
+       * @param[in] forEachRow  functor (visit, label), calls visit(i, cols, n)
+       *                        once per row, see patternRows
+       * @details               - count pass fixes the columns, blocks and encoded
+       *                          bytes of each row
+       *                        - encode pass writes skip pointers, block offsets
+       *                          and gaps of each row at the offsets of its first block
+       */
+      template <typename RowsFn>
+        void assemble(lno_t nrows, lno_t ncols, const RowsFn &forEachRow)
+        {
+          numRows = nrows;
+          numCols = ncols;
+
+          row_map = matrixOps::lno_view_t ("row_map", numRows + 1);
+          block_map = matrixOps::lno_view_t ("block_map", numRows + 1);
+          matrixOps::lno_view_t row_bytes ("row_bytes", numRows + 1);
+
+          forEachRow([&](const lno_t i, const lno_t *cols, size_type n)
+          {
+            row_map(i + 1) = n;
+            block_map(i + 1) = (n + blockSize - 1) / blockSize;
+
+            size_type bytes = 0;
+            for(size_type k = 0; k < n; k += blockSize)
+              bytes += encodedBytes(cols + k, std::min((size_type) blockSize, n - k));
+            row_bytes(i + 1) = bytes;
+          }, "pairg::compressedIndex::count");
+
+          matrixOps::prefixSum(row_map);
+          size_type blocks = matrixOps::prefixSum(block_map);
+          size_type bytes = matrixOps::prefixSum(row_bytes);
+
+          block_first = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("block_first"), blocks);
+          block_offset = matrixOps::lno_view_t ("block_offset", blocks + 1);
+          data = byte_view_t ("data", bytes);
+          block_offset(blocks) = bytes;
+
+          forEachRow([&](const lno_t i, const lno_t *cols, size_type n)
+          {
+            size_type offset = row_bytes(i);
+
+            for(size_type b = block_map(i); b < block_map(i+1); b++)
+            {
+              const lno_t *block = cols + (b - block_map(i)) * blockSize;
+              size_type length = blockLength(i, b);
+
+              block_first(b) = block[0];
+              block_offset(b) = offset;
+              encodeBlock(block, length, data.data() + offset);
+              offset += encodedBytes(block, length);
+            }
+          }, "pairg::compressedIndex::encode");
+        }
+
+      /**
+       * @brief                 count of columns in block b of row i
+       */
+      size_type blockLength(lno_t i, size_type b) const
+      {
+        size_type skipped = (b - block_map(i)) * blockSize;
+        return std::min((size_type) blockSize, row_map(i+1) - row_map(i) - skipped);
+      }
+
+      /**
+       * @brief                 bytes needed to store a gap, 1 to 4
+       */
+      static int gapBytes(uint32_t gap)
+      {
+        return gap < (1U << 8) ? 1 : gap < (1U << 16) ? 2 : gap < (1U << 24) ? 3 : 4;
+      }
+
+      /**
+       * @brief                 encoded size of a block of n sorted columns
+       */
+      static size_type encodedBytes(const lno_t *cols, size_type n)
+      {
+        size_type gaps = n - 1;
+        size_type bytes = (gaps + 3) / 4;
+
+        for(size_type k = 1; k < n; k++)
+          bytes += gapBytes(cols[k] - cols[k-1]);
+
+        return bytes;
+      }
+
+      /**
+       * @brief                 encode gaps of a block of n sorted columns,
+       *                        control bytes first, then gap bytes
+       */
+      static void encodeBlock(const lno_t *cols, size_type n, uint8_t *out)
+      {
+        size_type gaps = n - 1;
+        uint8_t *control = out;
+        uint8_t *bytes = out + (gaps + 3) / 4;
+
+        for(size_type k = 0; k < gaps; k++)
+        {
+          uint32_t gap = cols[k+1] - cols[k];
+          int len = gapBytes(gap);
+
+          control[k >> 2] |= (len - 1) << (2 * (k & 3));
+
+          for(int l = 0; l < len; l++)
+            *bytes++ = (gap >> (8 * l)) & 0xFF;
+        }
+      }
+
+      /**
+       * @brief                 decode a block of n columns starting at column 'first'
+       */
+      static void decodeBlock(const uint8_t *in, lno_t first, size_type n, lno_t *cols)
+      {
+        size_type gaps = n - 1;
+        const uint8_t *control = in;
+        const uint8_t *bytes = in + (gaps + 3) / 4;
+
+        cols[0] = first;
+
+        for(size_type k = 0; k < gaps; k++)
+        {
+          int len = ((control[k >> 2] >> (2 * (k & 3))) & 3) + 1;
+
+          uint32_t gap = 0;
+          for(int l = 0; l < len; l++)
+            gap |= (uint32_t) bytes[l] << (8 * l);
+          bytes += len;
+
+          cols[k+1] = cols[k] + gap;
+        }
+      }
+  };
+}
+
+#endif
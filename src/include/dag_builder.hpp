@@ -0,0 +1,289 @@
+/**
+ * @file    dag_builder.hpp
+ * @brief   valid-pairs pattern of an acyclic graph by one reverse-topological sweep
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_DAG_BUILDER_HPP
+#define PAIRG_DAG_BUILDER_HPP
+
+#include <cmath>
+#include <memory>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+#include "utility.hpp"
+#include "row_sweep.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief               decide whether the topological sweep is expected to be
+   *                      cheaper than matrix powers
+   * @return              false if A is not acyclic in vertex order
+   * @details             - sweep keeps, per vertex, a length mask of (d_up+1) bits
+   *                        for every target within d_up, powers need about
+   *                        log2(d_up) products with rows of the valid-pairs size
+   *                      - both row sizes are estimated from a sample of rows
+   *                        (see rowSweep), the constant favouring the sweep was
+   *                        measured on a chain graph
+   */
+  bool preferTopologicalSweep(const matrixOps::graph_t &A, const Parameters &p)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    if (!matrixOps::isUpperTriangular(A))
+      return false;
+
+    lno_t n = A.numRows();
+    const lno_t samples = std::min(n, (lno_t) 64);
+
+    rowSweep sweep (n);
+    std::vector<lno_t> cols;
+    double reach = 0, valid = 0;
+
+    for(lno_t s = 0; s < samples; s++)
+    {
+      lno_t i = (lno_t) ((double) s * n / samples);
+
+      sweep.compute(A, i, 0, p.d_up, cols);
+      reach += cols.size();
+
+      sweep.compute(A, i, p.d_low, p.d_up, cols);
+      valid += cols.size();
+    }
+
+    double words = (p.d_up + 64) / 64;
+    double sweepCost = reach * words;
+    double powerCost = 8.0 * std::log2(p.d_up + 2.0) * std::max(valid, (double) samples);
+
+    std::cout << "INFO, pairg::preferTopologicalSweep, acyclic graph, estimated cost of sweep = " << sweepCost << ", of powers = " << powerCost << "\n";
+
+    return sweepCost <= powerCost;
+  }
+
+  /**
+   * @brief               build sparsity pattern of valid vertex pairs of an acyclic graph
+   * @param[in] A         sparsity pattern of graph adjacency matrix, strictly upper
+   *                      triangular (see matrixOps::isUpperTriangular)
+   * @param[in] p         input parameters (distance constraints)
+   * @return              same pattern as A^d_low * (A+I)^(d_up-d_low), rows sorted
+   * @details             - every path from v either ends at v, or continues through
+   *                        a successor w; the targets of v with their feasible path
+   *                        lengths (bitmask over 0..d_up) are the union of those of
+   *                        its successors, shifted by one
+   *                      - successors have larger ids, vertices are processed in
+   *                        wavefronts of equal height (longest path to a sink),
+   *                        vertices within a wavefront in parallel
+   *                      - length masks of a vertex are freed once all its
+   *                        predecessors are done, only the valid-pairs rows are kept
+   */
+  matrixOps::graph_t buildValidPairsGraphDAG(const matrixOps::graph_t &A, const Parameters &p)
+  {
+    typedef matrixOps::lno_t lno_t;
+    typedef matrixOps::size_type size_type;
+
+    lno_t n = A.numRows();
+
+    //words per length mask, bit d = path of length d
+    const int words = (p.d_up + 64) / 64;
+    const int lastBits = p.d_up % 64 + 1;
+    const uint64_t lastWordMask = lastBits == 64 ? ~0ULL : (1ULL << lastBits) - 1;
+
+    //bits d_low..d_up
+    std::vector<uint64_t> validMask (words, 0);
+    for(int d = p.d_low; d <= p.d_up; d++)
+      validMask[d / 64] |= 1ULL << (d % 64);
+
+    //wavefronts
+    pairg::timer T1;
+    std::vector<lno_t> height (n, 0);
+    lno_t maxHeight = 0;
+
+    for(lno_t v = n - 1; v >= 0; v--)
+    {
+      for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+        height[v] = std::max(height[v], height[A.entries(k)] + 1);
+      maxHeight = std::max(maxHeight, height[v]);
+    }
+
+    std::vector<lno_t> waveStart (maxHeight + 2, 0), order (n);
+    for(lno_t v = 0; v < n; v++)
+      waveStart[height[v] + 1]++;
+    for(lno_t h = 0; h <= maxHeight; h++)
+      waveStart[h + 1] += waveStart[h];
+    {
+      std::vector<lno_t> cursor (waveStart.begin(), waveStart.end() - 1);
+      for(lno_t v = 0; v < n; v++)
+        order[cursor[height[v]]++] = v;
+    }
+
+    //predecessors still to be processed
+    Kokkos::View<lno_t*, matrixOps::Device> pending ("pending", n);
+    Kokkos::parallel_for("pairg::buildValidPairsGraphDAG::indegree", matrixOps::range_type(0, n), [&](const lno_t v)
+    {
+      for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+        Kokkos::atomic_increment(&pending(A.entries(k)));
+    });
+
+    std::cout << "INFO, pairg::buildValidPairsGraphDAG, count of wavefronts = " << maxHeight + 1 << ", time (ms): " << T1.elapsed() << "\n";
+
+    //feasible path lengths per target, live while predecessors are pending
+    struct lengthRow
+    {
+      std::vector<lno_t> cols;
+      std::vector<uint64_t> masks;                                    //words per column
+    };
+
+    //per-thread accumulator over targets, slots are epoch stamped
+    struct accumulator
+    {
+      std::vector<uint32_t> stamp;
+      std::vector<lno_t> slot;
+      uint32_t epoch;
+
+      std::vector<lno_t> touched;
+      std::vector<uint64_t> masks;
+      std::vector<uint64_t> shifted;
+
+      accumulator(lno_t n, int words) : stamp(n, 0), slot(n), epoch(0), shifted(words) {}
+    };
+
+    std::vector<lengthRow> lengths (n);
+    std::vector< std::vector<lno_t> > validCols (n);
+
+    Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+    std::vector< std::unique_ptr<accumulator> > scratch (token.size());
+
+    auto sweep = [&](const lno_t v, accumulator &acc)
+    {
+      if (++acc.epoch == 0)
+      {
+        std::fill(acc.stamp.begin(), acc.stamp.end(), 0);
+        acc.epoch = 1;
+      }
+
+      acc.touched.clear();
+      acc.masks.clear();
+
+      auto target = [&](const lno_t c)
+      {
+        if (acc.stamp[c] != acc.epoch)
+        {
+          acc.stamp[c] = acc.epoch;
+          acc.slot[c] = acc.touched.size();
+          acc.touched.push_back(c);
+          acc.masks.resize(acc.masks.size() + words, 0);
+        }
+        return acc.masks.data() + (size_type) acc.slot[c] * words;
+      };
+
+      //path of length 0
+      target(v)[0] |= 1ULL;
+
+      for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+      {
+        const lengthRow &succ = lengths[A.entries(k)];
+
+        for(std::size_t e = 0; e < succ.cols.size(); e++)
+        {
+          const uint64_t *m = succ.masks.data() + e * words;
+
+          //shift by one edge, lengths beyond d_up are dropped
+          uint64_t *shifted = acc.shifted.data();
+          bool any = false;
+          for(int w = 0; w < words; w++)
+          {
+            shifted[w] = (m[w] << 1) | (w > 0 ? m[w-1] >> 63 : 0);
+            if (w == words - 1)
+              shifted[w] &= lastWordMask;
+            any = any || shifted[w];
+          }
+
+          if (any)
+          {
+            uint64_t *t = target(succ.cols[e]);
+            for(int w = 0; w < words; w++)
+              t[w] |= shifted[w];
+          }
+        }
+      }
+
+      //emit sorted
+      std::sort(acc.touched.begin(), acc.touched.end());
+
+      lengthRow &row = lengths[v];
+      row.cols = acc.touched;
+      row.masks.resize(acc.masks.size());
+
+      for(std::size_t e = 0; e < acc.touched.size(); e++)
+      {
+        const uint64_t *m = acc.masks.data() + (size_type) acc.slot[acc.touched[e]] * words;
+        std::copy(m, m + words, row.masks.data() + e * words);
+
+        bool valid = false;
+        for(int w = 0; w < words; w++)
+          valid = valid || (m[w] & validMask[w]);
+        if (valid)
+          validCols[v].push_back(acc.touched[e]);
+      }
+
+      //successors no longer needed by any predecessor
+      for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+        if (Kokkos::atomic_fetch_add(&pending(A.entries(k)), (lno_t) -1) == 1)
+          lengths[A.entries(k)] = lengthRow();
+
+      if (pending(v) == 0)
+        row = lengthRow();
+    };
+
+    pairg::timer T2;
+    for(lno_t h = 0; h <= maxHeight; h++)
+    {
+      lno_t begin = waveStart[h], end = waveStart[h + 1];
+
+      //narrow wavefronts (e.g., long chains) are not worth a parallel launch
+      if (end - begin < 64)
+      {
+        if (!scratch[0])
+          scratch[0].reset(new accumulator(n, words));
+        for(lno_t r = begin; r < end; r++)
+          sweep(order[r], *scratch[0]);
+      }
+      else
+      {
+        Kokkos::parallel_for("pairg::buildValidPairsGraphDAG::sweep", matrixOps::range_type(begin, end), [&](const lno_t r)
+        {
+          int t = token.acquire();
+          if (!scratch[t])
+            scratch[t].reset(new accumulator(n, words));
+          sweep(order[r], *scratch[t]);
+          token.release(t);
+        });
+      }
+    }
+    std::cout << "INFO, pairg::buildValidPairsGraphDAG, time to sweep wavefronts (ms): " << T2.elapsed() << "\n";
+
+    //assemble
+    pairg::timer T3;
+    matrixOps::lno_view_t row_map ("row_map", n + 1);
+    Kokkos::parallel_for("pairg::buildValidPairsGraphDAG::count", matrixOps::range_type(0, n), [&](const lno_t v)
+    {
+      row_map(v + 1) = validCols[v].size();
+    });
+
+    size_type nnz = matrixOps::prefixSum(row_map);
+    matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+    Kokkos::parallel_for("pairg::buildValidPairsGraphDAG::fill", matrixOps::range_type(0, n), [&](const lno_t v)
+    {
+      std::copy(validCols[v].begin(), validCols[v].end(), entries.data() + row_map(v));
+      std::vector<lno_t>().swap(validCols[v]);
+    });
+    std::cout << "INFO, pairg::buildValidPairsGraphDAG, time to assemble pattern (ms): " << T3.elapsed() << ", nnz = " << nnz << "\n";
+
+    return matrixOps::graph_t(entries, row_map);
+  }
+}
+
+#endif
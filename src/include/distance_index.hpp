@@ -0,0 +1,240 @@
+/**
+ * @file    distance_index.hpp
+ * @brief   valid-pairs index that also reports the feasible path lengths
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_DISTANCE_INDEX_HPP
+#define PAIRG_DISTANCE_INDEX_HPP
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     index where each valid pair (i,j) carries a bitmask of the
+   *            path lengths in [d_low, d_up] that are feasible from v_i to v_j
+   * @details   - bit t of the mask is set iff there is a walk of length
+   *              exactly d_low + t; masks take (d_up - d_low) / 64 + 1 words
+   *            - C = A^d_low is computed as a sparsity pattern (see
+   *              matrixOps::power), the window is then swept level by level:
+   *              row i of level t+1 is row i of level t times A, i.e., the
+   *              (A+I)^(d_up-d_low) factor is evaluated in a semiring that
+   *              keeps the mask of levels instead of a single bit
+   *            - entries within a row are sorted by column
+   */
+  class distanceSetIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      typedef Kokkos::View<uint64_t*, matrixOps::Device> word_view_t;
+
+      //distance limits the index was built for
+      int d_low, d_up;
+
+      //count of rows (= count of columns), count of mask words per entry
+      lno_t numRows;
+      int words;
+
+      //row i spans [row_map(i), row_map(i+1)), mask of entry k spans [k * words, (k+1) * words)
+      matrixOps::lno_view_t row_map;
+      matrixOps::lno_nnz_view_t entries;
+      word_view_t masks;
+
+      distanceSetIndex() : d_low(0), d_up(0), numRows(0), words(0) {}
+
+      /**
+       * @brief                 build index
+       * @param[in]   A         sparsity pattern of graph adjacency matrix
+       * @param[in]   p         input parameters (distance constraints)
+       */
+      void build(const matrixOps::graph_t &A, const Parameters &p)
+      {
+        d_low = p.d_low;
+        d_up = p.d_up;
+        numRows = A.numRows();
+        words = (d_up - d_low) / 64 + 1;
+
+        pairg::timer T1;
+        matrixOps::graph_t C = matrixOps::power(A, d_low);
+        std::cout << "INFO, pairg::distanceSetIndex::build, time to raise adjacency matrix (ms): " << T1.elapsed() << "\n";
+
+        pairg::timer T2;
+        Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+        std::vector<levelScratch> scratch (token.size(), levelScratch(numRows));
+
+        //symbolic phase
+        row_map = matrixOps::lno_view_t ("row_map", numRows + 1);
+        Kokkos::parallel_for("pairg::distanceSetIndex::symbolic", range_type(0, numRows), [&](const lno_t i)
+        {
+          int t = token.acquire();
+          sweepRow(A, C, i, scratch[t]);
+
+          size_type distinct = 0;
+          for(std::size_t k = 0; k < scratch[t].hits.size(); k++)
+            if (k == 0 || scratch[t].hits[k].first != scratch[t].hits[k-1].first)
+              distinct++;
+
+          row_map(i + 1) = distinct;
+          token.release(t);
+        });
+
+        size_type nnz = matrixOps::prefixSum(row_map);
+        entries = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+        masks = word_view_t ("masks", nnz * words);
+
+        //numeric phase
+        Kokkos::parallel_for("pairg::distanceSetIndex::numeric", range_type(0, numRows), [&](const lno_t i)
+        {
+          int t = token.acquire();
+          sweepRow(A, C, i, scratch[t]);
+
+          size_type pos = row_map(i);
+          const auto &hits = scratch[t].hits;
+
+          for(std::size_t k = 0; k < hits.size(); k++)
+          {
+            if (k > 0 && hits[k].first != hits[k-1].first)
+              pos++;
+
+            entries(pos) = hits[k].first;
+            masks(pos * words + (hits[k].second >> 6)) |= 1ULL << (hits[k].second & 63);
+          }
+
+          token.release(t);
+        });
+
+        std::cout << "INFO, pairg::distanceSetIndex::build, time to sweep distance window (ms): " << T2.elapsed() << "\n";
+      }
+
+      /**
+       * @brief                 query whether a path of length in [d_low, d_up] exists
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        return distanceMask(i, j) != nullptr;
+      }
+
+      /**
+       * @brief                 mask of feasible path lengths from v_i to v_j,
+       *                        bit t stands for length d_low + t
+       * @return                pointer to 'words' mask words, nullptr if no
+       *                        length in [d_low, d_up] is feasible
+       */
+      const uint64_t* distanceMask(lno_t i, lno_t j) const
+      {
+        if (i >= numRows || j >= numRows) {
+          std::cout << "WARNING, pairg::distanceSetIndex::distanceMask, query index out of range" << std::endl;
+          return nullptr;
+        }
+
+        const lno_t *begin = entries.data() + row_map(i);
+        const lno_t *end = entries.data() + row_map(i + 1);
+        const lno_t *it = std::lower_bound(begin, end, j);
+
+        if (it == end || *it != j)
+          return nullptr;
+
+        return masks.data() + (it - entries.data()) * words;
+      }
+
+      /**
+       * @brief                 feasible path lengths from v_i to v_j within [d_low, d_up],
+       *                        in increasing order
+       */
+      std::vector<int> distances(lno_t i, lno_t j) const
+      {
+        std::vector<int> result;
+        const uint64_t *mask = distanceMask(i, j);
+
+        if (mask)
+          for(int t = 0; t <= d_up - d_low; t++)
+            if ((mask[t >> 6] >> (t & 63)) & 1ULL)
+              result.push_back(d_low + t);
+
+        return result;
+      }
+
+      /**
+       * @brief                 total size (in bytes) of index arrays
+       */
+      std::size_t memoryBytes() const
+      {
+        return row_map.extent(0) * sizeof(size_type)
+          + entries.extent(0) * sizeof(lno_t)
+          + masks.extent(0) * sizeof(uint64_t);
+      }
+
+      /**
+       * @brief                 print index properties to stdout
+       */
+      void printStats() const
+      {
+        std::cout << "INFO, pairg::distanceSetIndex::printStats, rows:" << numRows << ", entries:" << entries.extent(0) << ", mask words per entry:" << words << "\n";
+        std::cout << "INFO, pairg::distanceSetIndex::printStats, size (bytes):" << memoryBytes() << "\n";
+      }
+
+    private:
+
+      /**
+       * @brief                 per-thread buffers for sweepRow()
+       */
+      struct levelScratch
+      {
+        std::vector<uint64_t> seen;                           //bitmap over columns
+        std::vector<lno_t> current, next;                     //vertices at current and next level
+        std::vector< std::pair<lno_t, int> > hits;            //(column, level)
+
+        levelScratch(lno_t n) : seen((n + 63) / 64, 0) {}
+      };
+
+      /**
+       * @brief                 collect (column, level) pairs of row i, sorted
+       * @details               level 0 is row i of C = A^d_low, level t+1 holds
+       *                        the distinct out-neighbors of level t
+       */
+      void sweepRow(const matrixOps::graph_t &A, const matrixOps::graph_t &C, lno_t i, levelScratch &s) const
+      {
+        s.hits.clear();
+        s.current.assign(C.entries.data() + C.row_map(i), C.entries.data() + C.row_map(i+1));
+
+        for(int level = 0; level <= d_up - d_low && !s.current.empty(); level++)
+        {
+          for(auto v : s.current)
+            s.hits.emplace_back(v, level);
+
+          if (level == d_up - d_low)
+            break;
+
+          s.next.clear();
+          for(auto v : s.current)
+            for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+            {
+              lno_t w = A.entries(k);
+              uint64_t bit = 1ULL << (w & 63);
+
+              if (!(s.seen[w >> 6] & bit))
+              {
+                s.seen[w >> 6] |= bit;
+                s.next.push_back(w);
+              }
+            }
+
+          for(auto w : s.next)
+            s.seen[w >> 6] = 0;
+
+          std::swap(s.current, s.next);
+        }
+
+        std::sort(s.hits.begin(), s.hits.end());
+      }
+  };
+}
+
+#endif
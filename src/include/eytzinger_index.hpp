@@ -0,0 +1,166 @@
+/**
+ * @file    eytzinger_index.hpp
+ * @brief   valid-pairs index with long rows laid out in Eytzinger (BFS) order
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_EYTZINGER_INDEX_HPP
+#define PAIRG_EYTZINGER_INDEX_HPP
+
+#include "spgemm_utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     valid-pairs index tuned for search within long rows
+   * @details   - rows longer than linearScanLimit columns are stored in
+   *              Eytzinger order, i.e., breadth-first order of the implicit
+   *              binary search tree over the sorted row; the top levels of the
+   *              search share a few cache lines, and the cache line holding the
+   *              node four levels down is prefetched while descending
+   *            - shorter rows stay sorted and are searched with a branch-free
+   *              linear scan, which the compiler vectorizes
+   *            - alternative to matrixOps::indexForQuery; build using build()
+   *              from a row-sorted sparsity pattern
+   */
+  class eytzingerIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      //rows with more columns are stored in Eytzinger order
+      static const int linearScanLimit = 64;
+
+      //count of rows (= count of columns)
+      lno_t numRows;
+
+      //columns of row i span [row_map(i), row_map(i+1))
+      matrixOps::lno_view_t row_map;
+      matrixOps::lno_nnz_view_t entries;
+
+      eytzingerIndex() : numRows(0) {}
+
+      /**
+       * @brief                 build index from a sparsity pattern
+       * @param[in]   G         valid-pairs pattern, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::graph_t &G)
+      {
+        numRows = G.numRows();
+
+        row_map = matrixOps::lno_view_t (Kokkos::ViewAllocateWithoutInitializing("row_map"), numRows + 1);
+        Kokkos::deep_copy(row_map, G.row_map);
+
+        entries = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("entries"), G.entries.extent(0));
+
+        Kokkos::parallel_for("pairg::eytzingerIndex::layout", range_type(0, numRows), [&](const lno_t i)
+        {
+          const lno_t *sorted = G.entries.data() + row_map(i);
+          lno_t *out = entries.data() + row_map(i);
+          size_type n = row_map(i+1) - row_map(i);
+
+          if (n > linearScanLimit)
+          {
+            size_type pos = 0;
+            permute(sorted, out, n, 1, pos);
+          }
+          else
+            std::copy(sorted, sorted + n, out);
+        });
+      }
+
+      /**
+       * @brief                 build index from a matrix
+       * @param[in]   A         valid-pairs matrix, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::crsMat_t &A)
+      {
+        build(A.graph);
+      }
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        if (i >= numRows || j >= numRows) {
+          std::cout << "WARNING, pairg::eytzingerIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        const lno_t *row = entries.data() + row_map(i);
+        size_type n = row_map(i+1) - row_map(i);
+
+        if (n <= linearScanLimit)
+        {
+          //count of columns less than j
+          size_type less = 0;
+          for(size_type k = 0; k < n; k++)
+            less += (row[k] < j);
+
+          return less < n && row[less] == j;
+        }
+
+        //1-based tree position k is stored at row[k-1]
+        size_type k = 1;
+        while (k <= n)
+        {
+          __builtin_prefetch(row + 16 * k - 1);
+          k = 2 * k + (row[k-1] < j);
+        }
+
+        //undo the right turns taken after the last left turn
+        k >>= __builtin_ffsll(~k);
+
+        return k != 0 && row[k-1] == j;
+      }
+
+      /**
+       * @brief                 count of rows stored in Eytzinger order
+       */
+      lno_t treeRowCount() const
+      {
+        lno_t count = 0;
+
+        Kokkos::parallel_reduce("pairg::eytzingerIndex::treeRowCount", range_type(0, numRows), [&](const lno_t i, lno_t &update)
+        {
+          update += (row_map(i+1) - row_map(i) > linearScanLimit);
+        }, count);
+
+        return count;
+      }
+
+      /**
+       * @brief                 print index properties to stdout
+       */
+      void printStats() const
+      {
+        std::cout << "INFO, pairg::eytzingerIndex::printStats, rows:" << numRows << ", rows in Eytzinger order:" << treeRowCount() << "\n";
+        std::cout << "INFO, pairg::eytzingerIndex::printStats, entries:" << entries.extent(0) << "\n";
+      }
+
+    private:
+
+      /**
+       * @brief                 write sorted values into Eytzinger order by an
+       *                        in-order walk of the implicit tree rooted at k
+       */
+      static void permute(const lno_t *sorted, lno_t *out, size_type n, size_type k, size_type &pos)
+      {
+        if (k <= n)
+        {
+          permute(sorted, out, n, 2 * k, pos);
+          out[k-1] = sorted[pos++];
+          permute(sorted, out, n, 2 * k + 1, pos);
+        }
+      }
+  };
+}
+
+#endif
@@ -0,0 +1,830 @@
+/**
+ * @file    graph_ingest.hpp
+ * @brief   single-pass construction of the adjacency pattern from a graph file
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_GRAPH_INGEST_HPP
+#define PAIRG_GRAPH_INGEST_HPP
+
+#include <fstream>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <cstring>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "spgemm_utility.hpp"
+#include "utility.hpp"
+
+//External includes
+#include "vg/io/stream.hpp"
+#include "vg/vg.pb.h"
+
+namespace pairg
+{
+  /**
+   * @brief     builds the character-level adjacency pattern directly from
+   *            node lengths and edges, without psgl::graphLoader
+   * @details   - nodes and edges may be added concurrently, each thread
+   *              appends to its own part
+   *            - sequences are not kept, only their lengths
+   *            - node ids of an acyclic graph are relabeled in topological
+   *              order, cyclic graphs keep their ids, like the loader does;
+   *              the order is the one psgl picks, so the pattern is the same
+   *              as psgl::CSR_char_container
+   *            - only out-adjacency is built, straight into Kokkos views
+   */
+  class graphIngest
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+
+      graphIngest() : parts(omp_get_max_threads()) {}
+
+      /**
+       * @brief                 add a node, node ids are expected to be 0..n-1
+       * @param[in] length      count of characters in the node label
+       */
+      void addNode(int64_t id, std::size_t length)
+      {
+        part &p = parts[omp_get_thread_num()];
+        p.nodes.emplace_back(id, length);
+        p.maxId = std::max(p.maxId, id);
+      }
+
+      /**
+       * @brief                 add a directed edge between two nodes
+       */
+      void addEdge(int64_t from, int64_t to)
+      {
+        parts[omp_get_thread_num()].edges.emplace_back(from, to);
+      }
+
+      /**
+       * @brief                 character-level adjacency pattern of the nodes
+       *                        and edges added so far, rows sorted
+       */
+      matrixOps::graph_t adjacencyGraph() const
+      {
+        pairg::timer T1;
+
+        //node lengths
+        int64_t maxId = -1;
+        size_type nodeCount = 0;
+        for(auto &p : parts)
+        {
+          maxId = std::max(maxId, p.maxId);
+          nodeCount += p.nodes.size();
+        }
+
+        if (maxId < 0 || nodeCount != (size_type) maxId + 1)
+        {
+          std::cerr << "ERROR, pairg::graphIngest::adjacencyGraph, expected contiguous node ids 0.." << maxId << ", found " << nodeCount << " nodes" << std::endl;
+          exit(1);
+        }
+
+        lno_t N = maxId + 1;
+        std::vector<lno_t> length (N, 0);
+        bool invalid = false;
+
+        Kokkos::parallel_for("pairg::graphIngest::lengths", matrixOps::range_type(0, parts.size()), [&](const lno_t t)
+        {
+          for(auto &n : parts[t].nodes)
+            length[n.first] = n.second;
+        });
+
+        for(lno_t v = 0; v < N; v++)
+          invalid = invalid || length[v] == 0;
+
+        //node-level out-adjacency
+        matrixOps::lno_view_t node_map ("node_map", N + 1);
+        Kokkos::parallel_for("pairg::graphIngest::degrees", matrixOps::range_type(0, parts.size()), [&](const lno_t t)
+        {
+          for(auto &e : parts[t].edges)
+            if (e.first >= 0 && e.first < N && e.second >= 0 && e.second < N)
+              Kokkos::atomic_increment(&node_map(e.first + 1));
+        });
+
+        size_type nodeEdges = matrixOps::prefixSum(node_map);
+        size_type edgeCount = 0;
+        for(auto &p : parts)
+          edgeCount += p.edges.size();
+
+        if (invalid || nodeEdges != edgeCount)
+        {
+          std::cerr << "ERROR, pairg::graphIngest::adjacencyGraph, found a node with empty sequence or an edge to an unknown node" << std::endl;
+          exit(1);
+        }
+
+        matrixOps::lno_nnz_view_t node_adj (Kokkos::ViewAllocateWithoutInitializing("node_adj"), nodeEdges);
+        {
+          matrixOps::lno_view_t cursor (Kokkos::ViewAllocateWithoutInitializing("cursor"), N);
+          Kokkos::parallel_for("pairg::graphIngest::cursor", matrixOps::range_type(0, N), [&](const lno_t v)
+          {
+            cursor(v) = node_map(v);
+          });
+
+          Kokkos::parallel_for("pairg::graphIngest::edges", matrixOps::range_type(0, parts.size()), [&](const lno_t t)
+          {
+            for(auto &e : parts[t].edges)
+              node_adj(Kokkos::atomic_fetch_add(&cursor(e.first), (size_type) 1)) = e.second;
+          });
+        }
+
+        //slots above were claimed in scheduling order, sort each row so that
+        //the topological order below, and thus vertex ids, are reproducible
+        Kokkos::parallel_for("pairg::graphIngest::sortEdges", matrixOps::range_type(0, N), [&](const lno_t v)
+        {
+          std::sort(node_adj.data() + node_map(v), node_adj.data() + node_map(v + 1));
+        });
+
+        //topological order of nodes, identity if cyclic
+        std::vector<lno_t> position = topologicalPositions(node_map, node_adj, N);
+
+        //first character of each node
+        std::vector<lno_t> nodeAt (N);
+        for(lno_t v = 0; v < N; v++)
+          nodeAt[position[v]] = v;
+
+        std::vector<lno_t> first (N);
+        lno_t n = 0;
+        for(lno_t r = 0; r < N; r++)
+        {
+          first[nodeAt[r]] = n;
+          n += length[nodeAt[r]];
+        }
+
+        //character-level pattern: a chain within each node, last character
+        //of a node to first characters of its successors
+        matrixOps::lno_view_t row_map ("row_map", n + 1);
+        Kokkos::parallel_for("pairg::graphIngest::count", matrixOps::range_type(0, N), [&](const lno_t v)
+        {
+          lno_t last = first[v] + length[v] - 1;
+          for(lno_t c = first[v]; c < last; c++)
+            row_map(c + 1) = 1;
+          row_map(last + 1) = node_map(v + 1) - node_map(v);
+        });
+
+        size_type nnz = matrixOps::prefixSum(row_map);
+        matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+        Kokkos::parallel_for("pairg::graphIngest::fill", matrixOps::range_type(0, N), [&](const lno_t v)
+        {
+          lno_t last = first[v] + length[v] - 1;
+          for(lno_t c = first[v]; c < last; c++)
+            entries(row_map(c)) = c + 1;
+
+          size_type out = row_map(last);
+          for(size_type k = node_map(v); k < node_map(v+1); k++)
+            entries(out++) = first[node_adj(k)];
+          std::sort(entries.data() + row_map(last), entries.data() + out);
+        });
+
+        std::cout << "INFO, pairg::graphIngest::adjacencyGraph, n = " << n << ", m = " << nnz << ", time (ms): " << T1.elapsed() << std::endl;
+
+        return matrixOps::graph_t(entries, row_map);
+      }
+
+    private:
+
+      struct part
+      {
+        std::vector< std::pair<lno_t, lno_t> > nodes;       //(id, length)
+        std::vector< std::pair<lno_t, lno_t> > edges;       //(from, to)
+        int64_t maxId;
+
+        part() : maxId(-1) {}
+      };
+
+      std::vector<part> parts;
+
+      /**
+       * @brief                 position of each node in a topological order, identity
+       *                        if cyclic
+       * @details               same order as psgl::CSR_container::sort, so that vertex ids
+       *                        match the graph loader (and -f node) on every format:
+       *                        Kahn's algorithm picks the next node at random among the
+       *                        ready ones, with psgl's fixed seed, once to detect cycles
+       *                        and once more for the order. psgl keeps its generator in a
+       *                        function-local static, so ids match its first load in a
+       *                        process
+       */
+      static std::vector<lno_t> topologicalPositions(const matrixOps::lno_view_t &node_map, const matrixOps::lno_nnz_view_t &node_adj, lno_t N)
+      {
+        std::mt19937 gen(41);
+        std::vector<lno_t> order;
+
+        bool acyclic = randomKahn(node_map, node_adj, N, gen, order);
+
+        std::vector<lno_t> position (N);
+
+        if (acyclic)
+        {
+          std::cout << "INFO, pairg::graphIngest, acyclic graph detected, relabeling nodes in topological order" << std::endl;
+          randomKahn(node_map, node_adj, N, gen, order);
+          for(lno_t r = 0; r < N; r++)
+            position[order[r]] = r;
+        }
+        else
+        {
+          std::cout << "INFO, pairg::graphIngest, cyclic graph detected, skipping topological sort" << std::endl;
+          std::iota(position.begin(), position.end(), 0);
+        }
+
+        return position;
+      }
+
+      /**
+       * @brief                 one run of Kahn's algorithm, next node picked uniformly
+       *                        at random among the ready ones, in insertion order
+       *                        (psgl::random::select over a std::list)
+       * @param[out] order      nodes in the order they were removed
+       * @return                true if all nodes were removed, i.e., acyclic
+       * @details               ready nodes keep their insertion slot, a Fenwick tree
+       *                        over slots finds the k-th live one in O(log N), so
+       *                        many sources or components do not make it quadratic
+       *                        (psgl walks its list, O(count of ready nodes) a pick)
+       */
+      static bool randomKahn(const matrixOps::lno_view_t &node_map, const matrixOps::lno_nnz_view_t &node_adj, lno_t N, std::mt19937 &gen, std::vector<lno_t> &order)
+      {
+        std::vector<lno_t> indegree (N, 0);
+        for(size_type k = 0; k < node_adj.extent(0); k++)
+          indegree[node_adj(k)]++;
+
+        //node in each insertion slot (-1 once removed), Fenwick tree of live
+        //slots (1-based); slots are renumbered when they run out, so the tree
+        //stays within a small multiple of the ready count and in cache
+        std::vector<lno_t> slot, tree;
+        lno_t capacity = 0, top = 0, ready = 0;
+
+        auto update = [&](lno_t s, lno_t delta)
+        {
+          for(s++; s <= capacity; s += s & -s)
+            tree[s] += delta;
+        };
+
+        auto renumber = [&]()
+        {
+          slot.erase(std::remove(slot.begin(), slot.end(), -1), slot.end());
+          capacity = std::max<lno_t>(64, 4 * ready);
+          slot.reserve(capacity);
+
+          //linear-time build, all live slots are 0..ready-1
+          tree.assign(capacity + 1, 0);
+          for(lno_t s = 1; s <= capacity; s++)
+          {
+            tree[s] += s <= ready;
+            if (s + (s & -s) <= capacity)
+              tree[s + (s & -s)] += tree[s];
+          }
+
+          for(top = 1; top * 2 <= capacity; top *= 2);
+        };
+
+        auto push = [&](lno_t v)
+        {
+          if ((lno_t) slot.size() == capacity)
+            renumber();
+
+          update(slot.size(), 1);
+          slot.push_back(v);
+          ready++;
+        };
+
+        //slot of the k-th (0-based) live one
+        auto select = [&](lno_t k)
+        {
+          lno_t s = 0;
+          for(lno_t step = top; step > 0; step >>= 1)
+            if (s + step <= capacity && tree[s + step] <= k)
+            {
+              s += step;
+              k -= tree[s];
+            }
+          return s;
+        };
+
+        for(lno_t v = 0; v < N; v++)
+          if (indegree[v] == 0)
+            push(v);
+
+        order.clear();
+        order.reserve(N);
+
+        while (ready > 0)
+        {
+          std::uniform_int_distribution<> dis(0, ready - 1);
+          lno_t pick = select(dis(gen));
+          lno_t v = slot[pick];
+
+          slot[pick] = -1;
+          update(pick, -1);
+          ready--;
+          order.push_back(v);
+
+          for(size_type k = node_map(v); k < node_map(v + 1); k++)
+            if (--indegree[node_adj(k)] == 0)
+              push(node_adj(k));
+        }
+
+        return (lno_t) order.size() == N;
+      }
+  };
+
+  /**
+   * @brief               build adjacency pattern from a .vg file
+   * @details             - chunks of the protobuf stream are decoded once, in
+   *                        parallel across threads (vg::io::for_each_parallel)
+   *                      - vg node ids start at 1, a dummy node 0 with label "N"
+   *                        is added, as psgl::graphLoader does
+   */
+  matrixOps::graph_t ingestVG(const std::string &filename)
+  {
+    std::ifstream in (filename, std::ios::binary);
+    if (!in)
+    {
+      std::cerr << filename << " not accessible." << std::endl;
+      exit(1);
+    }
+
+    pairg::timer T1;
+    graphIngest ingest;
+    ingest.addNode(0, 1);
+
+    std::atomic<bool> bidirected (false);
+
+    std::function<void(vg::Graph&)> visit = [&](vg::Graph &chunk)
+    {
+      for (int i = 0; i < chunk.node_size(); i++)
+        ingest.addNode(chunk.node(i).id(), chunk.node(i).sequence().length());
+
+      for (int i = 0; i < chunk.edge_size(); i++)
+      {
+        auto &e = chunk.edge(i);
+
+        if (e.from_start() || e.to_end() || e.overlap() != 0)
+          bidirected = true;
+
+        ingest.addEdge(e.from(), e.to());
+      }
+    };
+
+    vg::io::for_each_parallel<vg::Graph>(in, visit);
+
+    if (bidirected)
+    {
+      std::cerr << "ERROR, pairg::ingestVG, bi-directed edges and overlaps are not supported yet" << std::endl;
+      exit(1);
+    }
+
+    std::cout << "INFO, pairg::ingestVG, time to decode " << filename << " (ms): " << T1.elapsed() << std::endl;
+
+    return ingest.adjacencyGraph();
+  }
+
+  /**
+   * @brief     read-only memory map of a text file, split into line-aligned
+   *            chunks for parallel parsing
+   */
+  class mappedLines
+  {
+    public:
+
+      //mapped file contents
+      const char *begin, *end;
+
+      mappedLines(const std::string &filename) : begin(nullptr), end(nullptr), addr(nullptr), size(0)
+      {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0)
+        {
+          std::cerr << filename << " not accessible." << std::endl;
+          exit(1);
+        }
+
+        size = st.st_size;
+        addr = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+        ::close(fd);
+
+        if (addr == MAP_FAILED || addr == nullptr)
+        {
+          std::cerr << "ERROR, pairg::mappedLines, cannot map " << filename << std::endl;
+          exit(1);
+        }
+
+        begin = (const char*) addr;
+        end = begin + size;
+      }
+
+      ~mappedLines()
+      {
+        munmap(addr, size);
+      }
+
+      mappedLines(const mappedLines &) = delete;
+      mappedLines& operator=(const mappedLines &) = delete;
+
+      /**
+       * @brief                 split [from, end) into line-aligned chunks
+       * @return                count + 1 chunk bounds, some chunks may be empty
+       */
+      std::vector<const char*> chunks(const char *from, int count) const
+      {
+        std::vector<const char*> bounds (count + 1);
+        bounds[0] = from;
+        bounds[count] = end;
+
+        for(int k = 1; k < count; k++)
+        {
+          const char *b = std::max(bounds[k-1], from + (end - from) / count * k);
+          bounds[k] = b < end ? lineEnd(b, end) + 1 : end;
+          bounds[k] = std::min(bounds[k], end);
+        }
+
+        return bounds;
+      }
+
+      /**
+       * @brief                 end of the line starting at p, newline or e
+       */
+      static const char* lineEnd(const char *p, const char *e)
+      {
+        const char *nl = (const char*) std::memchr(p, '\n', e - p);
+        return nl ? nl : e;
+      }
+
+      /**
+       * @brief                 count of lines in [b, e) for which fn(line, lineEnd) holds
+       */
+      template <typename Fn>
+        static matrixOps::lno_t countLines(const char *b, const char *e, const Fn &fn)
+        {
+          matrixOps::lno_t lines = 0;
+          for(const char *p = b; p < e; p = lineEnd(p, e) + 1)
+            if (fn(p, lineEnd(p, e)))
+              lines++;
+          return lines;
+        }
+
+    private:
+
+      void *addr;
+      std::size_t size;
+  };
+
+  /**
+   * @brief               build adjacency pattern from a .txt file
+   * @details             - same format as psgl::graphLoader::loadFromTxt: first line
+   *                        is the count of vertices, then one line per vertex with
+   *                        out-neighbor ids (0-based) followed by its label
+   *                      - file is memory-mapped and split into line-aligned chunks,
+   *                        lines are counted, then parsed, chunk-parallel
+   *                      - tokens are scanned in place, no per-line strings
+   */
+  matrixOps::graph_t ingestTxt(const std::string &filename)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    mappedLines file (filename);
+
+    pairg::timer T1;
+    auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+    //header
+    const char *body = std::min(mappedLines::lineEnd(file.begin, file.end) + 1, file.end);
+    long long declared = std::atoll(file.begin);
+
+    int chunks = omp_get_max_threads() * 8;
+    std::vector<const char*> bounds = file.chunks(body, chunks);
+
+    //lines per chunk, then first vertex id of each chunk
+    std::vector<lno_t> firstLine (chunks + 1, 0);
+    Kokkos::parallel_for("pairg::ingestTxt::count", matrixOps::range_type(0, chunks), [&](const int k)
+    {
+      firstLine[k + 1] = mappedLines::countLines(bounds[k], bounds[k+1], [](const char*, const char*) { return true; });
+    });
+    for(int k = 0; k < chunks; k++)
+      firstLine[k + 1] += firstLine[k];
+
+    if (declared <= 0 || firstLine[chunks] != declared)
+    {
+      std::cerr << "ERROR, pairg::ingestTxt, header of " << filename << " declares " << declared << " vertices, found " << firstLine[chunks] << " lines" << std::endl;
+      exit(1);
+    }
+
+    graphIngest ingest;
+    std::atomic<bool> malformed (false);
+
+    Kokkos::parallel_for("pairg::ingestTxt::parse", matrixOps::range_type(0, chunks), [&](const int k)
+    {
+      lno_t v = firstLine[k];
+
+      for(const char *p = bounds[k]; p < bounds[k+1]; v++)
+      {
+        const char *e = mappedLines::lineEnd(p, bounds[k+1]);
+        bool labeled = false;
+
+        while (p < e)
+        {
+          while (p < e && space(*p))
+            p++;
+          if (p == e)
+            break;
+
+          const char *t = p;
+          while (p < e && !space(*p))
+            p++;
+
+          const char *q = p;
+          while (q < e && space(*q))
+            q++;
+
+          //last token is the label, all others are neighbor ids
+          if (q == e)
+          {
+            ingest.addNode(v, p - t);
+            labeled = true;
+          }
+          else
+          {
+            int64_t id = 0;
+            for(const char *c = t; c < p; c++)
+            {
+              if (*c < '0' || *c > '9')
+                malformed = true;
+              id = id * 10 + (*c - '0');
+            }
+            ingest.addEdge(v, id);
+          }
+        }
+
+        if (!labeled)
+          malformed = true;
+
+        p = e + 1;
+      }
+    });
+
+    if (malformed)
+    {
+      std::cerr << "ERROR, pairg::ingestTxt, " << filename << " has a line without label or a non-numeric neighbor id" << std::endl;
+      exit(1);
+    }
+
+    std::cout << "INFO, pairg::ingestTxt, time to parse " << filename << " (ms): " << T1.elapsed() << std::endl;
+
+    return ingest.adjacencyGraph();
+  }
+
+  //[first, last) range of characters, e.g., within a mapped file
+  typedef std::pair<const char*, const char*> nameRange;
+
+  /**
+   * @brief     lookup of names (e.g., GFA segment names) to their index,
+   *            names are not copied
+   * @details   64-bit FNV-1a hash of each name, computed in parallel, sorted
+   *            together with the index; a lookup binary searches the hash and
+   *            compares names within the run of equal hashes
+   */
+  class segmentNames
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+
+      /**
+       * @param[in] names       name of each index, kept by reference
+       */
+      segmentNames(const std::vector<nameRange> &names) : names(names), sorted(names.size())
+      {
+        Kokkos::parallel_for("pairg::segmentNames::hash", matrixOps::range_type(0, names.size()), [&](const lno_t v)
+        {
+          sorted[v] = std::make_pair(hash(names[v]), v);
+        });
+
+        std::sort(sorted.begin(), sorted.end());
+      }
+
+      /**
+       * @brief                 index of a name, -1 if absent
+       */
+      lno_t find(const nameRange &name) const
+      {
+        uint64_t h = hash(name);
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), std::make_pair(h, (lno_t) -1));
+
+        for(; it != sorted.end() && it->first == h; it++)
+          if (equal(names[it->second], name))
+            return it->second;
+
+        return -1;
+      }
+
+      /**
+       * @brief                 index of a name that occurs more than once, -1 if all are distinct
+       */
+      lno_t duplicate() const
+      {
+        for(std::size_t k = 0; k < sorted.size(); k++)
+          for(std::size_t l = k + 1; l < sorted.size() && sorted[l].first == sorted[k].first; l++)
+            if (equal(names[sorted[k].second], names[sorted[l].second]))
+              return sorted[l].second;
+
+        return -1;
+      }
+
+    private:
+
+      const std::vector<nameRange> &names;
+      std::vector< std::pair<uint64_t, lno_t> > sorted;
+
+      static uint64_t hash(const nameRange &name)
+      {
+        uint64_t h = 14695981039346656037ULL;
+        for(const char *c = name.first; c < name.second; c++)
+        {
+          h ^= (unsigned char) *c;
+          h *= 1099511628211ULL;
+        }
+        return h;
+      }
+
+      static bool equal(const nameRange &a, const nameRange &b)
+      {
+        return a.second - a.first == b.second - b.first && std::equal(a.first, a.second, b.first);
+      }
+  };
+
+  /**
+   * @brief               build adjacency pattern from a .gfa file
+   * @details             - S lines are segments, numbered 0.. in file order,
+   *                        L lines are links; other record types are skipped
+   *                      - only forward links are supported: (+, +) is an edge
+   *                        from -> to, (-, -) the same edge written in reverse;
+   *                        links must not overlap (0M or *)
+   *                      - file is memory-mapped and parsed chunk-parallel in
+   *                        three passes: count segments, read segments, read
+   *                        links once all segment names are known
+   */
+  matrixOps::graph_t ingestGFA(const std::string &filename)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    mappedLines file (filename);
+
+    pairg::timer T1;
+
+    //tab-separated fields of a line, trailing carriage return dropped
+    auto fields = [](const char *p, const char *e, std::vector< std::pair<const char*, const char*> > &f)
+    {
+      if (e > p && *(e-1) == '\r')
+        e--;
+
+      f.clear();
+      while (true)
+      {
+        const char *t = (const char*) std::memchr(p, '\t', e - p);
+        f.emplace_back(p, t ? t : e);
+        if (!t)
+          break;
+        p = t + 1;
+      }
+    };
+
+    auto record = [](const char *p, const char *e, char type)
+    {
+      return e - p > 1 && p[0] == type && p[1] == '\t';
+    };
+
+    int chunks = omp_get_max_threads() * 8;
+    std::vector<const char*> bounds = file.chunks(file.begin, chunks);
+
+    //segments per chunk, then id of the first segment of each chunk
+    std::vector<lno_t> firstSegment (chunks + 1, 0);
+    Kokkos::parallel_for("pairg::ingestGFA::count", matrixOps::range_type(0, chunks), [&](const int k)
+    {
+      firstSegment[k + 1] = mappedLines::countLines(bounds[k], bounds[k+1], [&](const char *p, const char *e) { return record(p, e, 'S'); });
+    });
+    for(int k = 0; k < chunks; k++)
+      firstSegment[k + 1] += firstSegment[k];
+
+    lno_t N = firstSegment[chunks];
+    if (N == 0)
+    {
+      std::cerr << "ERROR, pairg::ingestGFA, no segments found in " << filename << std::endl;
+      exit(1);
+    }
+
+    graphIngest ingest;
+    std::vector<nameRange> names (N);
+    std::atomic<bool> malformed (false);
+
+    Kokkos::parallel_for("pairg::ingestGFA::segments", matrixOps::range_type(0, chunks), [&](const int k)
+    {
+      std::vector< std::pair<const char*, const char*> > f;
+      lno_t v = firstSegment[k];
+
+      for(const char *p = bounds[k]; p < bounds[k+1]; p = mappedLines::lineEnd(p, bounds[k+1]) + 1)
+      {
+        const char *e = mappedLines::lineEnd(p, bounds[k+1]);
+        if (!record(p, e, 'S'))
+          continue;
+
+        fields(p, e, f);
+
+        //sequence may be omitted (*), lengths are then unknown
+        if (f.size() < 3 || f[2].second - f[2].first == 0 || (f[2].second - f[2].first == 1 && *f[2].first == '*'))
+          malformed = true;
+        else
+        {
+          names[v] = f[1];
+          ingest.addNode(v, f[2].second - f[2].first);
+        }
+        v++;
+      }
+    });
+
+    if (malformed)
+    {
+      std::cerr << "ERROR, pairg::ingestGFA, " << filename << " has a segment without sequence" << std::endl;
+      exit(1);
+    }
+
+    //segment name to vertex id
+    segmentNames ids (names);
+    lno_t duplicate = ids.duplicate();
+    if (duplicate >= 0)
+    {
+      std::cerr << "ERROR, pairg::ingestGFA, duplicate segment name " << std::string(names[duplicate].first, names[duplicate].second) << " in " << filename << std::endl;
+      exit(1);
+    }
+
+    std::atomic<bool> unknown (false), bidirected (false);
+
+    Kokkos::parallel_for("pairg::ingestGFA::links", matrixOps::range_type(0, chunks), [&](const int k)
+    {
+      std::vector< std::pair<const char*, const char*> > f;
+
+      for(const char *p = bounds[k]; p < bounds[k+1]; p = mappedLines::lineEnd(p, bounds[k+1]) + 1)
+      {
+        const char *e = mappedLines::lineEnd(p, bounds[k+1]);
+        if (!record(p, e, 'L'))
+          continue;
+
+        fields(p, e, f);
+        if (f.size() < 5)
+        {
+          malformed = true;
+          continue;
+        }
+
+        char fromOrient = f[2].second - f[2].first == 1 ? *f[2].first : '?';
+        char toOrient = f[4].second - f[4].first == 1 ? *f[4].first : '?';
+
+        auto overlapIs = [&](const char *cigar)
+        {
+          return f.size() > 5 && f[5].second - f[5].first == (std::ptrdiff_t) std::strlen(cigar) && std::equal(f[5].first, f[5].second, cigar);
+        };
+        bool noOverlap = f.size() <= 5 || overlapIs("*") || overlapIs("0M");
+
+        if (fromOrient != toOrient || (fromOrient != '+' && fromOrient != '-') || !noOverlap)
+        {
+          bidirected = true;
+          continue;
+        }
+
+        lno_t u = ids.find(f[1]), w = ids.find(f[3]);
+        if (u < 0 || w < 0)
+        {
+          unknown = true;
+          continue;
+        }
+
+        if (fromOrient == '+')
+          ingest.addEdge(u, w);
+        else
+          ingest.addEdge(w, u);
+      }
+    });
+
+    if (malformed || unknown || bidirected)
+    {
+      std::cerr << "ERROR, pairg::ingestGFA, " << filename << " has " << (malformed ? "a malformed link" : unknown ? "a link to an unknown segment" : "a reverse-complement or overlapping link, not supported yet") << std::endl;
+      exit(1);
+    }
+
+    std::cout << "INFO, pairg::ingestGFA, time to parse " << filename << " (ms): " << T1.elapsed() << ", segments = " << N << std::endl;
+
+    return ingest.adjacencyGraph();
+  }
+}
+
+#endif
@@ -6,81 +6,210 @@
 #ifndef PAIRG_HEURISTICS_HPP
 #define PAIRG_HEURISTICS_HPP
 
+#include <memory>
+
 #include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
 
 namespace pairg
 {
   /**
-   * @brief             implement a simple heuristic to check distance constraints
-   * @param[in] A       adjacency matrix (CSR formatted)
-   * @param[in] p       input parameters (pull distance constraints from here)
-   * @param[in] src     source vertex
-   * @param[in] target  target vertex
-   * @details           run BFS from source vertex up to d_2 levels and see if we reach
-   *                    the target vertex
-   * @return            boolean value (true if reached, false if not)
+   * @brief     reusable engine for distance queries without an index, i.e.,
+   *            search on the adjacency pattern
+   * @details   - exact semantics: true iff some walk from src to target has
+   *              length in [d_low, d_up]
+   *            - bidirectional: a breadth-first search backwards from the
+   *              target first records shortest distances to the target (up to
+   *              d_up), then a level-by-level sweep forward from the source
+   *              only keeps vertices v at level t with dist(v, target) <= d_up - t
+   *            - per-thread scratch is allocated once; visited marks are
+   *              epoch stamps, so nothing is cleared between levels or queries
+   *            - thread safe, queries may run inside Kokkos parallel regions
+   *              (see matrixOps::queryBatch)
    */
-  bool queryReachabilityBFS(const matrixOps::crsMat_t &A, const Parameters &p, matrixOps::lno_t src, matrixOps::lno_t target)
+  class boundedSearch
   {
-    if (src >= A.numRows() || target >= A.numCols()) {
-      std::cout << "WARNING, pairg::matrixOps::queryValue, query index out of range" << std::endl;
-      return false;
-    }
+    public:
 
-    assert(p.d_up > 0);
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
 
-    if (src == target)
-      return true;
+      //count of vertices
+      lno_t numVertices;
 
-    //Count of bfs levels 
-    int level = 0;
+      //vertex ids are a topological order of an acyclic graph
+      bool acyclic;
 
-    //dummy value to track BFS levels
-    matrixOps::lno_t dummy = std::numeric_limits<matrixOps::lno_t>::max();
+      /**
+       * @param[in]   A         sparsity pattern of graph adjacency matrix, kept by reference
+       * @param[in]   p         input parameters (distance constraints)
+       */
+      boundedSearch(const matrixOps::graph_t &A, const Parameters &p)
+        : numVertices(A.numRows()), acyclic(matrixOps::isUpperTriangular(A)), A(A), AT(matrixOps::transposeGraph(A)), d_low(p.d_low), d_up(p.d_up), scratch(token.size())
+      {}
 
-    //Mark all the vertices as not visited 
-    std::vector<bool> visited(A.numRows(), false);  
+      /**
+       * @brief                 query whether a walk of length in [d_low, d_up]
+       *                        exists from src to target
+       * @note                  vertex ids should be 0-based
+       */
+      bool queryValue(lno_t src, lno_t target)
+      {
+        if (src >= numVertices || target >= numVertices) {
+          std::cout << "WARNING, pairg::boundedSearch::queryValue, query index out of range" << std::endl;
+          return false;
+        }
 
-    //queue for putting visited vertices
-    std::list<matrixOps::lno_t> Q; 
-    Q.push_back(src);  visited[src] = true;
-    Q.push_back(dummy);   //to travel the levels
+        //no path leads back in topological order
+        if (acyclic && target <= src)
+          return target == src && d_low == 0;
 
-    while(!Q.empty() && level <= p.d_up) 
-    {
-      //pick vertex from queue
-      auto cur = Q.front();
-      Q.pop_front();
+        int t = token.acquire();
+        if (!scratch[t])
+          scratch[t].reset(new searchScratch(numVertices));
 
-      if (cur == dummy)
-      {
-        //moving to next level
-        level += 1;
-        Q.push_back(dummy);
+        bool found = search(*scratch[t], src, target);
+        token.release(t);
 
-        if (Q.front() == dummy)
-          break; //all vertices visited
+        return found;
       }
-      else
+
+      /**
+       * @brief                 count of edges leaving / entering vertex v
+       */
+      lno_t outDegree(lno_t v) const { return A.row_map(v+1) - A.row_map(v); }
+      lno_t inDegree(lno_t v) const { return AT.row_map(v+1) - AT.row_map(v); }
+
+    private:
+
+      /**
+       * @brief     per-thread buffers
+       */
+      struct searchScratch
       {
-        //check if we hit the target vertex
-        if (cur == target)
-          return true;
+        //backward search: distance to target, valid iff stamp matches
+        std::vector<uint32_t> distStamp;
+        std::vector<int> dist;
+        uint32_t queryEpoch;
+
+        //forward sweep: vertex already in next level, valid iff stamp matches
+        std::vector<uint32_t> levelStamp;
+        uint32_t levelEpoch;
+
+        //flat frontier buffers, reused across levels and queries
+        std::vector<lno_t> current, next;
 
-        //Explore its neighbors
-        for(auto i = A.graph.row_map(cur); i < A.graph.row_map(cur+1); i++)
+        searchScratch(lno_t n) : distStamp(n, 0), dist(n), queryEpoch(0), levelStamp(n, 0), levelEpoch(0) {}
+
+        uint32_t nextEpoch(uint32_t &epoch, std::vector<uint32_t> &stamps)
         {
-          auto neighbor = A.graph.entries(i);
-          if (!visited[neighbor])
+          //reset stamps once every 2^32 - 1 epochs
+          if (++epoch == 0)
           {
-            visited[neighbor] = true;
-            Q.push_back(neighbor);
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
           }
+          return epoch;
+        }
+      };
+
+      const matrixOps::graph_t &A;
+      matrixOps::graph_t AT;
+      int d_low, d_up;
+
+      Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+      std::vector< std::unique_ptr<searchScratch> > scratch;
+
+      bool search(searchScratch &s, lno_t src, lno_t target)
+      {
+        //backward breadth-first search from target, shortest distances up to d_up
+        uint32_t q = s.nextEpoch(s.queryEpoch, s.distStamp);
+
+        s.current.assign(1, target);
+        s.distStamp[target] = q;
+        s.dist[target] = 0;
+
+        //shortest walk is already long enough
+        auto shortestSuffices = [&]()
+        {
+          return s.distStamp[src] == q && s.dist[src] >= d_low;
+        };
+
+        if (shortestSuffices())
+          return true;
+
+        for(int level = 1; level <= d_up && !s.current.empty(); level++)
+        {
+          s.next.clear();
+          for(auto v : s.current)
+            for(size_type k = AT.row_map(v); k < AT.row_map(v+1); k++)
+            {
+              lno_t w = AT.entries(k);
+              if (s.distStamp[w] != q)
+              {
+                s.distStamp[w] = q;
+                s.dist[w] = level;
+                s.next.push_back(w);
+              }
+            }
+          std::swap(s.current, s.next);
+
+          if (shortestSuffices())
+            return true;
+        }
+
+        if (s.distStamp[src] != q)
+          return false;
+
+        //shortest walk is too short, sweep forward with exact levels up to d_low;
+        //level t keeps vertices v with dist(v, target) <= d_up - t, so a non-empty
+        //level d_low proves a walk of length in [d_low, d_up]
+        auto canReach = [&](lno_t v, int level)
+        {
+          return s.distStamp[v] == q && s.dist[v] <= d_up - level;
+        };
+
+        s.current.assign(1, src);
+
+        for(int level = 0; level < d_low && !s.current.empty(); level++)
+        {
+          uint32_t e = s.nextEpoch(s.levelEpoch, s.levelStamp);
+
+          s.next.clear();
+          for(auto v : s.current)
+            for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+            {
+              lno_t w = A.entries(k);
+              if (s.levelStamp[w] != e && canReach(w, level + 1))
+              {
+                s.levelStamp[w] = e;
+                s.next.push_back(w);
+              }
+            }
+
+          std::swap(s.current, s.next);
         }
+
+        return !s.current.empty();
       }
-    }
- 
-    return false;
+  };
+
+  /**
+   * @brief             check distance constraints by search on the adjacency matrix
+   * @param[in] A       adjacency matrix (CSR formatted)
+   * @param[in] p       input parameters (pull distance constraints from here)
+   * @param[in] src     source vertex
+   * @param[in] target  target vertex
+   * @details           convenience wrapper for a single query, builds a
+   *                    boundedSearch engine on every call; use the engine
+   *                    directly for repeated queries
+   * @return            boolean value (true if a walk of length in [d_low, d_up]
+   *                    exists, false if not)
+   */
+  bool queryReachabilityBFS(const matrixOps::crsMat_t &A, const Parameters &p, matrixOps::lno_t src, matrixOps::lno_t target)
+  {
+    boundedSearch engine (A.graph, p);
+    return engine.queryValue(src, target);
   }
 }
 
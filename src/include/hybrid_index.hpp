@@ -0,0 +1,204 @@
+/**
+ * @file    hybrid_index.hpp
+ * @brief   valid-pairs index with adaptive (sorted list / bitmap) row storage
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_HYBRID_INDEX_HPP
+#define PAIRG_HYBRID_INDEX_HPP
+
+#include "spgemm_utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     valid-pairs index where each row is stored either as a sorted
+   *            column list (sparse rows) or as a bitmap over a column window
+   *            (dense rows)
+   * @details   - a row is stored as bitmap if the bitmap covering its column
+   *              span takes no more memory than its sorted column list
+   *            - bitmap window of a dense row starts at its first column,
+   *              rounded down to a multiple of 64
+   *            - sparse rows are queried by binary search, dense rows by a
+   *              single bit test
+   *            - build using build() from a row-sorted sparsity pattern
+   */
+  class hybridIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      //row storage kinds
+      enum rowKind : uint8_t { SPARSE = 0, DENSE = 1 };
+
+      typedef Kokkos::View<uint8_t*, matrixOps::Device> kind_view_t;
+      typedef Kokkos::View<uint64_t*, matrixOps::Device> word_view_t;
+
+      //count of rows (= count of columns)
+      lno_t numRows;
+
+      //storage kind of each row, size = numRows
+      kind_view_t row_kind;
+
+      //sorted columns of sparse rows, row i spans [sparse_offsets(i), sparse_offsets(i+1))
+      matrixOps::lno_view_t sparse_offsets;
+      matrixOps::lno_nnz_view_t sparse_entries;
+
+      //bitmap words of dense rows, row i spans [dense_offsets(i), dense_offsets(i+1))
+      matrixOps::lno_view_t dense_offsets;
+      word_view_t dense_words;
+
+      //first column covered by the bitmap of each dense row
+      matrixOps::lno_nnz_view_t window_begin;
+
+      hybridIndex() : numRows(0) {}
+
+      /**
+       * @brief                 build index from a sparsity pattern
+       * @param[in]   G         valid-pairs pattern, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::graph_t &G)
+      {
+        numRows = G.numRows();
+
+        row_kind = kind_view_t ("row_kind", numRows);
+        window_begin = matrixOps::lno_nnz_view_t ("window_begin", numRows);
+        sparse_offsets = matrixOps::lno_view_t ("sparse_offsets", numRows + 1);
+        dense_offsets = matrixOps::lno_view_t ("dense_offsets", numRows + 1);
+
+        //decide storage kind of each row and its size
+        Kokkos::parallel_for("pairg::hybridIndex::classify", range_type(0, numRows), [&](const lno_t i)
+        {
+          size_type begin = G.row_map(i);
+          size_type end = G.row_map(i+1);
+          size_type count = end - begin;
+
+          if (count > 0)
+          {
+            lno_t first = G.entries(begin) & ~63;
+            size_type words = (G.entries(end - 1) - first) / 64 + 1;
+
+            if (words * sizeof(uint64_t) <= count * sizeof(lno_t))
+            {
+              row_kind(i) = DENSE;
+              window_begin(i) = first;
+              dense_offsets(i+1) = words;
+              return;
+            }
+          }
+
+          row_kind(i) = SPARSE;
+          sparse_offsets(i+1) = count;
+        });
+
+        size_type sparse_nnz = matrixOps::prefixSum(sparse_offsets);
+        size_type dense_nnz = matrixOps::prefixSum(dense_offsets);
+
+        sparse_entries = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("sparse_entries"), sparse_nnz);
+        dense_words = word_view_t ("dense_words", dense_nnz);
+
+        //fill row contents
+        Kokkos::parallel_for("pairg::hybridIndex::fill", range_type(0, numRows), [&](const lno_t i)
+        {
+          size_type begin = G.row_map(i);
+          size_type end = G.row_map(i+1);
+
+          if (row_kind(i) == SPARSE)
+          {
+            std::copy(G.entries.data() + begin, G.entries.data() + end, sparse_entries.data() + sparse_offsets(i));
+          }
+          else
+          {
+            uint64_t *words = dense_words.data() + dense_offsets(i);
+
+            for(size_type k = begin; k < end; k++)
+            {
+              lno_t bit = G.entries(k) - window_begin(i);
+              words[bit >> 6] |= 1ULL << (bit & 63);
+            }
+          }
+        });
+      }
+
+      /**
+       * @brief                 build index from a matrix
+       * @param[in]   A         valid-pairs matrix, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::crsMat_t &A)
+      {
+        build(A.graph);
+      }
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        if (i >= numRows || j >= numRows) {
+          std::cout << "WARNING, pairg::hybridIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        if (row_kind(i) == SPARSE)
+        {
+          return std::binary_search(sparse_entries.data() + sparse_offsets(i), sparse_entries.data() + sparse_offsets(i+1), j);
+        }
+        else
+        {
+          if (j < window_begin(i))
+            return false;
+
+          size_type bit = j - window_begin(i);
+          if (bit >= 64 * (dense_offsets(i+1) - dense_offsets(i)))
+            return false;
+
+          return (dense_words(dense_offsets(i) + (bit >> 6)) >> (bit & 63)) & 1ULL;
+        }
+      }
+
+      /**
+       * @brief                 count of rows stored as bitmaps
+       */
+      lno_t denseRowCount() const
+      {
+        lno_t count = 0;
+
+        Kokkos::parallel_reduce("pairg::hybridIndex::denseRowCount", range_type(0, numRows), [&](const lno_t i, lno_t &update)
+        {
+          update += row_kind(i);
+        }, count);
+
+        return count;
+      }
+
+      /**
+       * @brief                 total size (in bytes) of index arrays
+       */
+      std::size_t memoryBytes() const
+      {
+        return row_kind.extent(0) * sizeof(uint8_t)
+          + window_begin.extent(0) * sizeof(lno_t)
+          + (sparse_offsets.extent(0) + dense_offsets.extent(0)) * sizeof(size_type)
+          + sparse_entries.extent(0) * sizeof(lno_t)
+          + dense_words.extent(0) * sizeof(uint64_t);
+      }
+
+      /**
+       * @brief                 print index properties to stdout
+       */
+      void printStats() const
+      {
+        std::cout << "INFO, pairg::hybridIndex::printStats, rows:" << numRows << ", dense rows:" << denseRowCount() << "\n";
+        std::cout << "INFO, pairg::hybridIndex::printStats, sparse entries:" << sparse_entries.extent(0) << ", bitmap words:" << dense_words.extent(0) << "\n";
+        std::cout << "INFO, pairg::hybridIndex::printStats, size (bytes):" << memoryBytes() << "\n";
+      }
+  };
+}
+
+#endif
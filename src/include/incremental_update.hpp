@@ -0,0 +1,452 @@
+/**
+ * @file    incremental_update.hpp
+ * @brief   update of a valid-pairs index after local changes to the graph
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_INCREMENTAL_UPDATE_HPP
+#define PAIRG_INCREMENTAL_UPDATE_HPP
+
+#include <cstdio>
+#include <memory>
+#include <unordered_set>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+#include "index_file.hpp"
+#include "row_sweep.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     change to the character graph, in vertex ids of the indexed graph
+   * @details   new vertices take ids after the existing ones
+   */
+  struct graphDelta
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    //count of vertices after the change
+    lno_t numVertices;
+
+    //(u, v) edges
+    std::vector< std::pair<lno_t, lno_t> > addedEdges;
+    std::vector< std::pair<lno_t, lno_t> > removedEdges;
+
+    graphDelta() : numVertices(0) {}
+  };
+
+  /**
+   * @brief               apply a change to the adjacency pattern
+   * @return              adjacency pattern after the change, entries within
+   *                      changed rows are sorted
+   */
+  matrixOps::graph_t applyDelta(const matrixOps::graph_t &A, const graphDelta &delta)
+  {
+    typedef matrixOps::lno_t lno_t;
+    typedef matrixOps::size_type size_type;
+
+    lno_t n_old = A.numRows(), n = delta.numVertices;
+    assert(n >= n_old);
+
+    auto added = delta.addedEdges;
+    auto removed = delta.removedEdges;
+    std::sort(added.begin(), added.end());
+    std::sort(removed.begin(), removed.end());
+
+    for(auto *edges : {&added, &removed})
+      for(auto &e : *edges)
+        if (e.first < 0 || e.first >= n || e.second < 0 || e.second >= n)
+        {
+          std::cerr << "ERROR, pairg::applyDelta, edge (" << e.first << ", " << e.second << ") out of range" << std::endl;
+          exit(1);
+        }
+
+    //changed rows: old entries - removed + added
+    auto collectRow = [&](const lno_t i, std::vector<lno_t> &cols)
+    {
+      cols.clear();
+      if (i < n_old)
+        cols.assign(A.entries.data() + A.row_map(i), A.entries.data() + A.row_map(i+1));
+
+      auto r = std::equal_range(removed.begin(), removed.end(), std::make_pair(i, 0), [](const std::pair<lno_t,lno_t> &x, const std::pair<lno_t,lno_t> &y) { return x.first < y.first; });
+      for(auto it = r.first; it != r.second; it++)
+        cols.erase(std::remove(cols.begin(), cols.end(), it->second), cols.end());
+
+      auto a = std::equal_range(added.begin(), added.end(), std::make_pair(i, 0), [](const std::pair<lno_t,lno_t> &x, const std::pair<lno_t,lno_t> &y) { return x.first < y.first; });
+      for(auto it = a.first; it != a.second; it++)
+        cols.push_back(it->second);
+
+      std::sort(cols.begin(), cols.end());
+      cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    };
+
+    auto changed = [&](const lno_t i)
+    {
+      auto cmp = [](const std::pair<lno_t,lno_t> &x, const std::pair<lno_t,lno_t> &y) { return x.first < y.first; };
+      return i >= n_old || std::binary_search(added.begin(), added.end(), std::make_pair(i, 0), cmp)
+        || std::binary_search(removed.begin(), removed.end(), std::make_pair(i, 0), cmp);
+    };
+
+    matrixOps::lno_view_t row_map ("row_map", n + 1);
+    Kokkos::parallel_for("pairg::applyDelta::count", matrixOps::range_type(0, n), [&](const lno_t i)
+    {
+      if (changed(i))
+      {
+        std::vector<lno_t> cols;
+        collectRow(i, cols);
+        row_map(i + 1) = cols.size();
+      }
+      else
+        row_map(i + 1) = A.row_map(i+1) - A.row_map(i);
+    });
+
+    size_type nnz = matrixOps::prefixSum(row_map);
+    matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+    Kokkos::parallel_for("pairg::applyDelta::fill", matrixOps::range_type(0, n), [&](const lno_t i)
+    {
+      if (changed(i))
+      {
+        std::vector<lno_t> cols;
+        collectRow(i, cols);
+        std::copy(cols.begin(), cols.end(), entries.data() + row_map(i));
+      }
+      else
+        std::copy(A.entries.data() + A.row_map(i), A.entries.data() + A.row_map(i+1), entries.data() + row_map(i));
+    });
+
+    return matrixOps::graph_t(entries, row_map);
+  }
+
+  /**
+   * @brief               rows of the valid-pairs pattern that may change
+   * @param[in] A         adjacency pattern after the change
+   * @param[in] n_old     count of vertices before the change
+   * @return              sorted row ids: new vertices, and vertices with a walk
+   *                      of length < d_up to the source of an added or removed edge
+   * @details             - reverse breadth-first search from the changed sources,
+   *                        search cost and memory are proportional to the size
+   *                        of the affected region
+   *                      - the reverse adjacency is built by a transpose of A,
+   *                        linear in nnz(A), which is small next to the index
+   */
+  std::vector<matrixOps::lno_t> affectedRows(const matrixOps::graph_t &A, matrixOps::lno_t n_old, const graphDelta &delta, const Parameters &p)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    lno_t n = A.numRows();
+    matrixOps::graph_t AT = matrixOps::transposeGraph(A);
+
+    std::unordered_set<lno_t> visited;
+    std::vector<lno_t> current, next, rows;
+
+    auto visit = [&](lno_t v)
+    {
+      if (visited.insert(v).second)
+        next.push_back(v);
+    };
+
+    for(auto &e : delta.addedEdges)
+      visit(e.first);
+    for(auto &e : delta.removedEdges)
+      visit(e.first);
+    for(lno_t v = n_old; v < n; v++)
+      visit(v);
+
+    for(int level = 0; !next.empty(); level++)
+    {
+      rows.insert(rows.end(), next.begin(), next.end());
+
+      std::swap(current, next);
+      next.clear();
+
+      if (level + 1 >= p.d_up)
+        break;
+
+      for(auto v : current)
+        for(auto k = AT.row_map(v); k < AT.row_map(v+1); k++)
+          visit(AT.entries(k));
+    }
+
+    std::sort(rows.begin(), rows.end());
+    return rows;
+  }
+
+  /**
+   * @brief               recompute selected rows of the valid-pairs pattern
+   * @param[in] A         adjacency pattern after the change
+   * @param[in] rows      rows to recompute
+   * @return              sorted columns of each selected row
+   * @details             each row is computed by a level-by-level sweep from its
+   *                      vertex up to d_up levels (see rowSweep); sweep bitmaps
+   *                      are allocated by a thread on its first row, so a small
+   *                      update allocates at most one per row
+   */
+  std::vector< std::vector<matrixOps::lno_t> > recomputeRows(const matrixOps::graph_t &A, const std::vector<matrixOps::lno_t> &rows, const Parameters &p)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    lno_t count = rows.size();
+    std::vector< std::vector<lno_t> > newRows (count);
+
+    Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+    std::vector< std::unique_ptr<rowSweep> > sweeps (token.size());
+
+    Kokkos::parallel_for("pairg::recomputeRows", matrixOps::range_type(0, count), [&](const lno_t r)
+    {
+      int t = token.acquire();
+      if (!sweeps[t])
+        sweeps[t].reset(new rowSweep(A.numRows()));
+
+      sweeps[t]->compute(A, rows[r], p.d_low, p.d_up, newRows[r]);
+      token.release(t);
+    });
+
+    return newRows;
+  }
+
+  /**
+   * @brief               check that a saved pattern uses the vertex ids of an
+   *                      adjacency pattern, on rows a change leaves unaffected
+   * @param[in] B         valid-pairs pattern before the change
+   * @param[in] A         adjacency pattern after the change
+   * @param[in] rows      sorted affected rows, see affectedRows()
+   * @param[in] samples   count of unaffected rows compared, evenly spaced
+   * @return              false if a sampled row differs, e.g., if the graph was
+   *                      loaded with a different vertex order than the index
+   */
+  bool sameVertexIds(const matrixOps::graph_t &B, const matrixOps::graph_t &A, const std::vector<matrixOps::lno_t> &rows, const Parameters &p, matrixOps::lno_t samples = 256)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    lno_t n = std::min(B.numRows(), A.numRows());
+    std::vector<lno_t> sampled;
+
+    for(lno_t k = 0; k < samples; k++)
+    {
+      lno_t i = (lno_t) ((int64_t) k * n / samples);
+      if ((sampled.empty() || sampled.back() != i) && i < n && !std::binary_search(rows.begin(), rows.end(), i))
+        sampled.push_back(i);
+    }
+
+    std::vector< std::vector<lno_t> > expected = recomputeRows(A, sampled, p);
+
+    for(std::size_t r = 0; r < sampled.size(); r++)
+    {
+      lno_t i = sampled[r];
+      if (expected[r].size() != B.row_map(i+1) - B.row_map(i) || !std::equal(expected[r].begin(), expected[r].end(), B.entries.data() + B.row_map(i)))
+        return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief               splice recomputed rows into the existing pattern
+   * @param[in] n         count of rows after the change
+   * @param[in] newRows   sorted columns of each row in rows
+   */
+  matrixOps::graph_t spliceValidPairsRows(const matrixOps::graph_t &B, matrixOps::lno_t n, const std::vector<matrixOps::lno_t> &rows, const std::vector< std::vector<matrixOps::lno_t> > &newRows)
+  {
+    typedef matrixOps::lno_t lno_t;
+    typedef matrixOps::size_type size_type;
+
+    pairg::timer T1;
+
+    auto slot = [&](const lno_t i)
+    {
+      auto it = std::lower_bound(rows.begin(), rows.end(), i);
+      return (it != rows.end() && *it == i) ? lno_t(it - rows.begin()) : lno_t(-1);
+    };
+
+    matrixOps::lno_view_t row_map ("row_map", n + 1);
+    Kokkos::parallel_for("pairg::spliceValidPairsRows::count", matrixOps::range_type(0, n), [&](const lno_t i)
+    {
+      lno_t r = slot(i);
+      row_map(i + 1) = r >= 0 ? newRows[r].size() : B.row_map(i+1) - B.row_map(i);
+    });
+
+    size_type nnz = matrixOps::prefixSum(row_map);
+    matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+    Kokkos::parallel_for("pairg::spliceValidPairsRows::fill", matrixOps::range_type(0, n), [&](const lno_t i)
+    {
+      lno_t r = slot(i);
+      if (r >= 0)
+        std::copy(newRows[r].begin(), newRows[r].end(), entries.data() + row_map(i));
+      else
+        std::copy(B.entries.data() + B.row_map(i), B.entries.data() + B.row_map(i+1), entries.data() + row_map(i));
+    });
+    std::cout << "INFO, pairg::spliceValidPairsRows, time to splice rows (ms): " << T1.elapsed() << "\n";
+
+    return matrixOps::graph_t(entries, row_map);
+  }
+
+  /**
+   * @brief               recompute selected rows of the valid-pairs pattern and
+   *                      splice them into the existing pattern
+   * @param[in] B         valid-pairs pattern before the change
+   * @param[in] A         adjacency pattern after the change
+   * @param[in] rows      sorted rows to recompute, must include all new vertices
+   * @return              valid-pairs pattern after the change
+   * @details             selected rows are recomputed (see recomputeRows), other
+   *                      rows are copied, i.e., the splice is linear in the size
+   *                      of the index
+   */
+  matrixOps::graph_t spliceValidPairsRows(const matrixOps::graph_t &B, const matrixOps::graph_t &A, const std::vector<matrixOps::lno_t> &rows, const Parameters &p)
+  {
+    pairg::timer T1;
+    std::vector< std::vector<matrixOps::lno_t> > newRows = recomputeRows(A, rows, p);
+    std::cout << "INFO, pairg::spliceValidPairsRows, time to recompute " << rows.size() << " rows (ms): " << T1.elapsed() << "\n";
+
+    return spliceValidPairsRows(B, A.numRows(), rows, newRows);
+  }
+
+  /**
+   * @brief               update the valid-pairs pattern after a change to the graph
+   * @param[in] B         valid-pairs pattern before the change
+   * @param[in] A         adjacency pattern before the change
+   * @param[out] A_new    adjacency pattern after the change
+   * @return              valid-pairs pattern after the change
+   */
+  matrixOps::graph_t updateValidPairsGraph(const matrixOps::graph_t &B, const matrixOps::graph_t &A, const graphDelta &delta, const Parameters &p, matrixOps::graph_t &A_new)
+  {
+    A_new = applyDelta(A, delta);
+
+    std::vector<matrixOps::lno_t> rows = affectedRows(A_new, A.numRows(), delta, p);
+    std::cout << "INFO, pairg::updateValidPairsGraph, affected rows = " << rows.size() << " of " << A_new.numRows() << "\n";
+
+    return spliceValidPairsRows(B, A_new, rows, p);
+  }
+
+  /**
+   * @brief               update a saved index after a change to the graph
+   * @param[in] filename  index file, built with the distance limits in p
+   * @param[in] A         adjacency pattern before the change, in the vertex ids
+   *                      of the saved index
+   * @param[in] p         input parameters, graph file should hold the changed graph
+   * @return              adjacency pattern after the change
+   * @details             - a sample of unaffected rows is compared against the
+   *                        saved index first, see sameVertexIds()
+   *                      - if no vertex is added and every recomputed row keeps
+   *                        its length, the row map is unchanged and only the
+   *                        header and the recomputed rows are written in place;
+   *                        the header is invalidated (zero graph checksum) and
+   *                        synced before the rows are patched, and rewritten
+   *                        last, so an interrupted update is never reused.
+   *                        Processes that mapped the file earlier may see
+   *                        patched rows and should reopen it
+   *                      - otherwise the updated index is written next to the
+   *                        old one and renamed over it once complete, which is
+   *                        linear in the size of the index
+   */
+  matrixOps::graph_t updateIndexFile(const std::string &filename, const matrixOps::graph_t &A, const graphDelta &delta, const Parameters &p)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    matrixOps::graph_t A_new, B_new;
+    std::vector<lno_t> rows;
+    std::vector< std::vector<lno_t> > newRows;
+    std::vector<matrixOps::size_type> offsets;
+    indexFileHeader meta (p);
+    bool inPlace;
+
+    {
+      mappedIndex saved;
+      if (!saved.open(filename))
+      {
+        std::cerr << "ERROR, pairg::updateIndexFile, cannot map index file " << filename << std::endl;
+        exit(1);
+      }
+
+      if (saved.header.graphChecksum == 0)
+      {
+        std::cerr << "ERROR, pairg::updateIndexFile, " << filename << " was left invalid by an interrupted update, rebuild it" << std::endl;
+        exit(1);
+      }
+
+      if (saved.header.reordered() || indexFileHeader::orderCode(p.vorder) != 0)
+      {
+        std::cerr << "ERROR, pairg::updateIndexFile, update of an index with reordered vertices is not supported" << std::endl;
+        exit(1);
+      }
+
+      if (saved.header.d_low != p.d_low || saved.header.d_up != p.d_up || saved.graph.numRows() != A.numRows())
+      {
+        std::cerr << "ERROR, pairg::updateIndexFile, " << filename << " was built for different distance limits or graph size" << std::endl;
+        exit(1);
+      }
+
+      A_new = applyDelta(A, delta);
+      rows = affectedRows(A_new, A.numRows(), delta, p);
+      std::cout << "INFO, pairg::updateIndexFile, affected rows = " << rows.size() << " of " << A_new.numRows() << "\n";
+
+      if (!sameVertexIds(saved.graph, A_new, rows, p))
+      {
+        std::cerr << "ERROR, pairg::updateIndexFile, " << filename << " does not match the vertex ids of the graph" << std::endl;
+        exit(1);
+      }
+
+      newRows = recomputeRows(A_new, rows, p);
+
+      inPlace = A_new.numRows() == A.numRows();
+      for(std::size_t r = 0; r < rows.size() && inPlace; r++)
+        inPlace = newRows[r].size() == saved.graph.row_map(rows[r]+1) - saved.graph.row_map(rows[r]);
+
+      if (inPlace)
+      {
+        for(auto i : rows)
+          offsets.push_back(saved.graph.row_map(i));
+
+        meta.numRows = saved.header.numRows;
+        meta.nnz = saved.header.nnz;
+      }
+      else
+        B_new = spliceValidPairsRows(saved.graph, A_new.numRows(), rows, newRows);
+    }
+
+    if (inPlace)
+    {
+      //row map unchanged, overwrite recomputed rows; the header is made
+      //invalid first and written last, so a crash or failed write leaves a
+      //file that open() rejects instead of stale rows under a new checksum
+      pairg::timer T1;
+      indexFileHeader invalid = meta;
+      invalid.graphChecksum = 0;
+
+      int fd = ::open(filename.c_str(), O_WRONLY);
+      bool ok = fd >= 0 && pwrite(fd, &invalid, sizeof(invalid), 0) == (ssize_t) sizeof(invalid) && fdatasync(fd) == 0;
+
+      for(std::size_t r = 0; r < rows.size() && ok; r++)
+      {
+        std::size_t bytes = newRows[r].size() * sizeof(lno_t);
+        ok = pwrite(fd, newRows[r].data(), bytes, meta.entriesOffset() + offsets[r] * sizeof(lno_t)) == (ssize_t) bytes;
+      }
+
+      ok = ok && fdatasync(fd) == 0 && pwrite(fd, &meta, sizeof(meta), 0) == (ssize_t) sizeof(meta) && fdatasync(fd) == 0;
+
+      if (fd < 0 || ::close(fd) != 0 || !ok)
+      {
+        std::cerr << "ERROR, pairg::updateIndexFile, failed writing " << filename << ", index left invalid" << std::endl;
+        exit(1);
+      }
+      std::cout << "INFO, pairg::updateIndexFile, time to patch " << rows.size() << " rows in place (ms): " << T1.elapsed() << "\n";
+
+      return A_new;
+    }
+
+    std::string tmpfile = filename + ".tmp";
+    writeIndexFile(tmpfile, B_new, meta);
+
+    if (std::rename(tmpfile.c_str(), filename.c_str()) != 0)
+    {
+      std::cerr << "ERROR, pairg::updateIndexFile, cannot replace " << filename << std::endl;
+      exit(1);
+    }
+
+    return A_new;
+  }
+}
+
+#endif
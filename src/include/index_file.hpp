@@ -0,0 +1,381 @@
+/**
+ * @file    index_file.hpp
+ * @brief   on-disk storage of the valid-pairs index
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_INDEX_FILE_HPP
+#define PAIRG_INDEX_FILE_HPP
+
+#include <fstream>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     header of an index file
+   * @details   file layout:
+   *            - header
+   *            - row map, (numRows + 1) values of matrixOps::size_type
+   *            - entries, nnz values of matrixOps::lno_t, sorted within each row
+   *            - if vertices were reordered, new id of each vertex of the loaded
+   *              graph, numRows values of matrixOps::lno_t
+   *            an index file is reused only if its version, distance limits,
+   *            vertex order and graph checksum agree with the current run
+   */
+  struct indexFileHeader
+  {
+    char magic[8];
+    uint64_t version;
+    int64_t d_low, d_up;
+    int64_t order;                    //see orderCode()
+    uint64_t graphChecksum;
+    uint64_t numRows;
+    uint64_t nnz;
+
+    static const char* expectedMagic() { return "PAIRGIDX"; }
+
+    //bump whenever the file layout changes
+    static uint64_t currentVersion() { return 2; }
+
+    indexFileHeader() : version(currentVersion()), d_low(0), d_up(0), order(0), graphChecksum(0), numRows(0), nnz(0)
+    {
+      std::memcpy(magic, expectedMagic(), sizeof(magic));
+    }
+
+    /**
+     * @brief                 header describing an index for the given input parameters
+     */
+    explicit indexFileHeader(const Parameters &p) : indexFileHeader()
+    {
+      d_low = p.d_low;
+      d_up = p.d_up;
+      order = orderCode(p.vorder);
+      graphChecksum = fileChecksum(p.graphfile);
+    }
+
+    /**
+     * @brief                 code of a vertex order (see Parameters::vorder), 0 if vertices are not reordered
+     */
+    static int64_t orderCode(const std::string &vorder)
+    {
+      static const char *names[] = {"none", "rcm", "bfs", "topo"};
+
+      for(int64_t c = 0; c < 4; c++)
+        if (vorder.compare(names[c]) == 0)
+          return c;
+
+      std::cerr << "ERROR, pairg::indexFileHeader::orderCode, unknown vertex order " << vorder << std::endl;
+      exit(1);
+    }
+
+    bool reordered() const { return order != 0; }
+
+    bool valid() const
+    {
+      return std::memcmp(magic, expectedMagic(), sizeof(magic)) == 0 && version == currentVersion();
+    }
+
+    /**
+     * @brief                 check if index was built from the same graph with the same distance limits
+     */
+    bool matches(const indexFileHeader &other) const
+    {
+      //a zero checksum marks a file left by an interrupted update (see updateIndexFile)
+      return graphChecksum != 0 && d_low == other.d_low && d_up == other.d_up && order == other.order && graphChecksum == other.graphChecksum;
+    }
+
+    std::size_t rowMapOffset() const { return sizeof(indexFileHeader); }
+    std::size_t entriesOffset() const { return rowMapOffset() + (numRows + 1) * sizeof(matrixOps::size_type); }
+    std::size_t permutationOffset() const { return entriesOffset() + nnz * sizeof(matrixOps::lno_t); }
+    std::size_t fileSize() const { return permutationOffset() + (reordered() ? numRows : 0) * sizeof(matrixOps::lno_t); }
+
+    /**
+     * @brief                 64-bit hash of file size and contents
+     * @details               - file is mapped and split into chunks of 1 MB, each
+     *                          chunk is hashed in parallel (FNV-1a over 64-bit words,
+     *                          trailing bytes one at a time)
+     *                        - chunk hashes are combined in file order, so the
+     *                          result does not depend on the count of threads
+     */
+    static uint64_t fileChecksum(const std::string &filename)
+    {
+      int fd = ::open(filename.c_str(), O_RDONLY);
+      struct stat st;
+
+      if (fd < 0 || fstat(fd, &st) != 0)
+      {
+        std::cerr << "ERROR, pairg::indexFileHeader::fileChecksum, cannot open " << filename << std::endl;
+        exit(1);
+      }
+
+      const uint64_t offset = 14695981039346656037ULL, prime = 1099511628211ULL;
+      std::size_t size = st.st_size;
+      uint64_t hash = (offset ^ size) * prime;
+
+      if (size == 0)
+      {
+        ::close(fd);
+        return hash;
+      }
+
+      void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+
+      if (addr == MAP_FAILED)
+      {
+        std::cerr << "ERROR, pairg::indexFileHeader::fileChecksum, cannot map " << filename << std::endl;
+        exit(1);
+      }
+
+      const char *data = (const char*) addr;
+      const std::size_t chunk = 1 << 20;
+      matrixOps::lno_t chunks = (size + chunk - 1) / chunk;
+      std::vector<uint64_t> chunkHash (chunks);
+
+      Kokkos::parallel_for("pairg::indexFileHeader::fileChecksum", matrixOps::range_type(0, chunks), [&](const matrixOps::lno_t c)
+      {
+        const char *b = data + c * chunk;
+        const char *e = data + std::min(size, (c + 1) * chunk);
+        uint64_t h = offset;
+
+        for(; b + sizeof(uint64_t) <= e; b += sizeof(uint64_t))
+        {
+          uint64_t word;
+          std::memcpy(&word, b, sizeof(word));
+          h = (h ^ word) * prime;
+        }
+
+        for(; b < e; b++)
+          h = (h ^ (unsigned char) *b) * prime;
+
+        chunkHash[c] = h;
+      });
+
+      munmap(addr, size);
+
+      for(auto h : chunkHash)
+        hash = (hash ^ h) * prime;
+
+      return hash;
+    }
+  };
+
+  /**
+   * @brief     sequential writer of an index file
+   * @details   row map is written first, entries can then be appended in
+   *            row panels, in row order, followed by the vertex permutation
+   *            if the header says vertices were reordered
+   */
+  class indexFileWriter
+  {
+    public:
+
+      /**
+       * @brief                 create file, write header and row map
+       * @param[in]   meta      header with distance limits and graph checksum set
+       */
+      indexFileWriter(const std::string &filename, const matrixOps::lno_view_t &row_map, const indexFileHeader &meta)
+        : filename(filename), out(filename, std::ios::binary | std::ios::trunc), header(meta), written(0), permutationWritten(false)
+      {
+        if (!out)
+        {
+          std::cerr << "ERROR, pairg::indexFileWriter, cannot open " << filename << " for writing" << std::endl;
+          exit(1);
+        }
+
+        header.numRows = row_map.extent(0) - 1;
+        header.nnz = row_map(header.numRows);
+
+        out.write((const char*) &header, sizeof(header));
+        out.write((const char*) row_map.data(), row_map.extent(0) * sizeof(matrixOps::size_type));
+      }
+
+      /**
+       * @brief                 append entries of the next rows
+       */
+      void append(const matrixOps::lno_t *entries, std::size_t count)
+      {
+        out.write((const char*) entries, count * sizeof(matrixOps::lno_t));
+        written += count;
+      }
+
+      /**
+       * @brief                 write new id of each vertex, after all entries
+       */
+      void appendPermutation(const matrixOps::lno_nnz_view_t &toNew)
+      {
+        assert(written == header.nnz && header.reordered() && toNew.extent(0) == header.numRows);
+        out.write((const char*) toNew.data(), toNew.extent(0) * sizeof(matrixOps::lno_t));
+        permutationWritten = true;
+      }
+
+      /**
+       * @brief                 flush and close the file
+       */
+      void close()
+      {
+        assert(written == header.nnz && permutationWritten == header.reordered());
+        out.close();
+
+        if (!out)
+        {
+          std::cerr << "ERROR, pairg::indexFileWriter, failed writing " << filename << std::endl;
+          exit(1);
+        }
+      }
+
+    private:
+
+      std::string filename;
+      std::ofstream out;
+      indexFileHeader header;
+      uint64_t written;
+      bool permutationWritten;
+  };
+
+  /**
+   * @brief     write an in-memory index to file
+   * @param[in] toNew     vertex permutation, required iff meta says vertices were reordered
+   */
+  void writeIndexFile(const std::string &filename, const matrixOps::graph_t &G, const indexFileHeader &meta, const matrixOps::lno_nnz_view_t &toNew = matrixOps::lno_nnz_view_t())
+  {
+    matrixOps::lno_view_t row_map ("row_map", G.row_map.extent(0));
+    Kokkos::deep_copy(row_map, G.row_map);
+
+    indexFileWriter writer (filename, row_map, meta);
+    writer.append(G.entries.data(), G.entries.extent(0));
+    if (meta.reordered())
+      writer.appendPermutation(toNew);
+    writer.close();
+  }
+
+  /**
+   * @brief     read-only, memory-mapped view of an index file
+   * @details   - row map and entries are exposed as unmanaged views over the
+   *              mapped pages, i.e. pages are read from disk on demand and the
+   *              index never needs to fit in memory
+   *            - the mapping is private (copy-on-write): views are writable like
+   *              any graph_t, e.g., for sorting rows in place, but a write only
+   *              copies the touched page into memory and never reaches the file
+   */
+  class mappedIndex
+  {
+    public:
+
+      indexFileHeader header;
+
+      //pattern over the mapped file, query with matrixOps::queryValue()
+      matrixOps::graph_t graph;
+
+      //new id of each vertex of the loaded graph, empty if vertices were not reordered
+      matrixOps::lno_nnz_view_t permutation;
+
+      mappedIndex() : addr(nullptr), length(0) {}
+
+      ~mappedIndex()
+      {
+        unmap();
+      }
+
+      mappedIndex(const mappedIndex &) = delete;
+      mappedIndex& operator=(const mappedIndex &) = delete;
+
+      /**
+       * @brief                 map an index file
+       * @return                false if the file is missing or not a valid index file
+       *                        of the current version
+       */
+      bool open(const std::string &filename)
+      {
+        unmap();
+
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+          return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(indexFileHeader))
+        {
+          ::close(fd);
+          return false;
+        }
+
+        //private writable mapping, see class details
+        addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (addr == MAP_FAILED)
+        {
+          addr = nullptr;
+          return false;
+        }
+
+        length = st.st_size;
+        std::memcpy(&header, addr, sizeof(header));
+
+        if (!header.valid() || header.fileSize() != length)
+        {
+          std::cerr << "WARNING, pairg::mappedIndex::open, " << filename << " is not a valid index file" << std::endl;
+          unmap();
+          return false;
+        }
+
+        const char *base = (const char*) addr;
+        typename matrixOps::graph_t::row_map_type row_map ((const matrixOps::size_type*) (base + header.rowMapOffset()), header.numRows + 1);
+        matrixOps::lno_nnz_view_t entries ((matrixOps::lno_t*) (base + header.entriesOffset()), header.nnz);
+        graph = matrixOps::graph_t(entries, row_map);
+
+        if (header.reordered())
+          permutation = matrixOps::lno_nnz_view_t ((matrixOps::lno_t*) (base + header.permutationOffset()), header.numRows);
+
+        return true;
+      }
+
+      /**
+       * @brief                 map an index file if it was built for the expected
+       *                        graph and distance limits
+       * @return                false if the file is missing, invalid or stale
+       */
+      bool open(const std::string &filename, const indexFileHeader &expected)
+      {
+        if (!open(filename))
+          return false;
+
+        if (!header.matches(expected))
+        {
+          std::cout << "INFO, pairg::mappedIndex::open, " << filename << " was built for a different graph or distance limits" << std::endl;
+          unmap();
+          return false;
+        }
+
+        return true;
+      }
+
+    private:
+
+      void *addr;
+      std::size_t length;
+
+      void unmap()
+      {
+        graph = matrixOps::graph_t();
+        permutation = matrixOps::lno_nnz_view_t();
+
+        if (addr)
+          munmap(addr, length);
+
+        addr = nullptr;
+        length = 0;
+      }
+  };
+}
+
+#endif
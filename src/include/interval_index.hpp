@@ -0,0 +1,188 @@
+/**
+ * @file    interval_index.hpp
+ * @brief   valid-pairs index with run-length (interval) encoded rows
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_INTERVAL_INDEX_HPP
+#define PAIRG_INTERVAL_INDEX_HPP
+
+#include "spgemm_utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     valid-pairs index where each row is stored as a sorted list of
+   *            maximal runs of consecutive columns, (start, length) per run
+   * @details   - consecutive bases get consecutive vertex ids after the
+   *              topological sort, so rows of the index are mostly a few
+   *              contiguous column ranges
+   *            - queries binary-search the run starts of a row
+   *            - build either from a row-sorted sparsity pattern, or directly
+   *              from the two factors C, D of the valid-pairs pattern (C * D
+   *              is never materialized)
+   */
+  class intervalIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      //count of rows (= count of columns)
+      lno_t numRows;
+
+      //runs of row i span [row_map(i), row_map(i+1))
+      matrixOps::lno_view_t row_map;
+      matrixOps::lno_nnz_view_t run_start;
+      matrixOps::lno_nnz_view_t run_length;
+
+      intervalIndex() : numRows(0) {}
+
+      /**
+       * @brief                 build index from a sparsity pattern
+       * @param[in]   G         valid-pairs pattern, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::graph_t &G)
+      {
+        numRows = G.numRows();
+        row_map = matrixOps::lno_view_t ("row_map", numRows + 1);
+
+        Kokkos::parallel_for("pairg::intervalIndex::count", range_type(0, numRows), [&](const lno_t i)
+        {
+          row_map(i + 1) = countRuns(G.entries.data() + G.row_map(i), G.row_map(i+1) - G.row_map(i));
+        });
+
+        allocateRuns();
+
+        Kokkos::parallel_for("pairg::intervalIndex::fill", range_type(0, numRows), [&](const lno_t i)
+        {
+          writeRuns(G.entries.data() + G.row_map(i), G.row_map(i+1) - G.row_map(i), row_map(i));
+        });
+      }
+
+      /**
+       * @brief                 build index from a matrix
+       * @param[in]   A         valid-pairs matrix, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::crsMat_t &A)
+      {
+        build(A.graph);
+      }
+
+      /**
+       * @brief                 build index directly from the factors of the
+       *                        valid-pairs pattern C * D
+       * @details               rows of the product are computed twice (count
+       *                        and write pass), only runs are stored
+       */
+      void build(const matrixOps::graph_t &C, const matrixOps::graph_t &D)
+      {
+        numRows = C.numRows();
+        row_map = matrixOps::lno_view_t ("row_map", numRows + 1);
+
+        matrixOps::forEachProductRow(C, D, [&](const lno_t i, const std::vector<lno_t> &cols)
+        {
+          row_map(i + 1) = countRuns(cols.data(), cols.size());
+        }, "pairg::intervalIndex::count");
+
+        allocateRuns();
+
+        matrixOps::forEachProductRow(C, D, [&](const lno_t i, const std::vector<lno_t> &cols)
+        {
+          writeRuns(cols.data(), cols.size(), row_map(i));
+        }, "pairg::intervalIndex::fill");
+      }
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        if (i >= numRows || j >= numRows) {
+          std::cout << "WARNING, pairg::intervalIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        const lno_t *begin = run_start.data() + row_map(i);
+        const lno_t *end = run_start.data() + row_map(i + 1);
+
+        //last run starting at or before j
+        const lno_t *it = std::upper_bound(begin, end, j);
+        if (it == begin)
+          return false;
+
+        size_type k = (it - 1) - run_start.data();
+        return j < run_start(k) + run_length(k);
+      }
+
+      /**
+       * @brief                 total size (in bytes) of index arrays
+       */
+      std::size_t memoryBytes() const
+      {
+        return row_map.extent(0) * sizeof(size_type)
+          + (run_start.extent(0) + run_length.extent(0)) * sizeof(lno_t);
+      }
+
+      /**
+       * @brief                 print index properties to stdout
+       */
+      void printStats() const
+      {
+        std::cout << "INFO, pairg::intervalIndex::printStats, rows:" << numRows << ", runs:" << run_start.extent(0) << "\n";
+        std::cout << "INFO, pairg::intervalIndex::printStats, size (bytes):" << memoryBytes() << "\n";
+      }
+
+    private:
+
+      /**
+       * @brief                 count maximal runs of consecutive values in a sorted array
+       */
+      static size_type countRuns(const lno_t *cols, size_type n)
+      {
+        size_type runs = 0;
+
+        for(size_type k = 0; k < n; k++)
+          if (k == 0 || cols[k] != cols[k-1] + 1)
+            runs++;
+
+        return runs;
+      }
+
+      /**
+       * @brief                 write maximal runs of a sorted array, starting at run offset 'pos'
+       */
+      void writeRuns(const lno_t *cols, size_type n, size_type pos) const
+      {
+        for(size_type k = 0; k < n; k++)
+        {
+          if (k == 0 || cols[k] != cols[k-1] + 1)
+          {
+            run_start(pos) = cols[k];
+            run_length(pos) = 1;
+            pos++;
+          }
+          else
+            run_length(pos - 1)++;
+        }
+      }
+
+      /**
+       * @brief                 convert per-row run counts into offsets, allocate run arrays
+       */
+      void allocateRuns()
+      {
+        size_type runs = matrixOps::prefixSum(row_map);
+
+        run_start = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("run_start"), runs);
+        run_length = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("run_length"), runs);
+      }
+  };
+}
+
+#endif
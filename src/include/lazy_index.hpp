@@ -0,0 +1,197 @@
+/**
+ * @file    lazy_index.hpp
+ * @brief   valid-pairs index with rows computed on first access
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_LAZY_INDEX_HPP
+#define PAIRG_LAZY_INDEX_HPP
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+#include "row_sweep.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     index that computes a row of the valid-pairs pattern when it is
+   *            first queried, and keeps recent rows in a size-bounded LRU cache
+   * @details   - rows are computed by rowSweep on the adjacency pattern, so
+   *              there is no build step before the first query
+   *            - the cache is split into shards by row id, each shard has its
+   *              own lock, LRU list and share of the memory limit
+   *            - a row is held through a shared pointer, eviction never
+   *              invalidates a row that a concurrent query is still reading
+   *            - two threads missing on the same row may both compute it, the
+   *              first insertion wins
+   */
+  class lazyIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+
+      typedef std::shared_ptr< const std::vector<lno_t> > row_ptr;
+
+      //count of cache shards
+      static const int shardCount = 64;
+
+      //count of rows (= count of columns)
+      lno_t numRows;
+
+      /**
+       * @param[in]   A         sparsity pattern of graph adjacency matrix, kept by reference
+       * @param[in]   p         input parameters (distance constraints)
+       * @param[in]   capacity  memory limit (bytes) for cached rows
+       */
+      lazyIndex(const matrixOps::graph_t &A, const Parameters &p, std::size_t capacity)
+        : numRows(A.numRows()), A(A), d_low(p.d_low), d_up(p.d_up), shardCapacity(capacity / shardCount), sweeps(token.size()), hits(0), misses(0)
+      {}
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j)
+      {
+        if (i >= numRows || j >= numRows) {
+          std::cout << "WARNING, pairg::lazyIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        row_ptr row = getRow(i);
+        return std::binary_search(row->begin(), row->end(), j);
+      }
+
+      /**
+       * @brief                 sorted columns of row i, computed if not cached
+       */
+      row_ptr getRow(lno_t i)
+      {
+        row_ptr cached = findRow(i);
+        if (cached)
+          return cached;
+
+        misses++;
+        row_ptr row = computeRow(i);
+
+        cacheShard &shard = shards[i % shardCount];
+        std::lock_guard<std::mutex> lock (shard.mutex);
+
+        auto it = shard.position.find(i);
+        if (it != shard.position.end())
+          return it->second->second;
+
+        shard.lru.emplace_front(i, row);
+        shard.position[i] = shard.lru.begin();
+        shard.bytes += rowBytes(*row);
+
+        //evict least recently used rows, keep at least the new one
+        while (shard.bytes > shardCapacity && shard.lru.size() > 1)
+        {
+          auto &victim = shard.lru.back();
+          shard.bytes -= rowBytes(*victim.second);
+          shard.position.erase(victim.first);
+          shard.lru.pop_back();
+        }
+
+        return row;
+      }
+
+      /**
+       * @brief                 sorted columns of row i if cached, empty pointer
+       *                        otherwise (nothing is computed)
+       */
+      row_ptr findRow(lno_t i)
+      {
+        cacheShard &shard = shards[i % shardCount];
+        std::lock_guard<std::mutex> lock (shard.mutex);
+
+        auto it = shard.position.find(i);
+        if (it == shard.position.end())
+          return row_ptr();
+
+        //move to front
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        hits++;
+        return it->second->second;
+      }
+
+      /**
+       * @brief                 total size (in bytes) of cached rows
+       */
+      std::size_t cachedBytes()
+      {
+        std::size_t bytes = 0;
+
+        for(auto &shard : shards)
+        {
+          std::lock_guard<std::mutex> lock (shard.mutex);
+          bytes += shard.bytes;
+        }
+
+        return bytes;
+      }
+
+      /**
+       * @brief                 print cache statistics to stdout
+       */
+      void printStats()
+      {
+        std::cout << "INFO, pairg::lazyIndex::printStats, row cache hits:" << hits << ", misses:" << misses << "\n";
+        std::cout << "INFO, pairg::lazyIndex::printStats, cached rows size (bytes):" << cachedBytes() << ", limit (bytes):" << shardCapacity * shardCount << "\n";
+      }
+
+    private:
+
+      typedef std::list< std::pair<lno_t, row_ptr> > lru_list_t;
+
+      struct cacheShard
+      {
+        std::mutex mutex;
+        lru_list_t lru;                                               //most recent first
+        std::unordered_map<lno_t, lru_list_t::iterator> position;
+        std::size_t bytes = 0;
+      };
+
+      const matrixOps::graph_t &A;
+      int d_low, d_up;
+      std::size_t shardCapacity;
+
+      cacheShard shards[shardCount];
+
+      //per-thread sweep scratch, allocated on first miss of the thread
+      Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+      std::vector< std::unique_ptr<rowSweep> > sweeps;
+
+      std::atomic<std::size_t> hits, misses;
+
+      row_ptr computeRow(lno_t i)
+      {
+        auto cols = std::make_shared< std::vector<lno_t> >();
+
+        int t = token.acquire();
+        if (!sweeps[t])
+          sweeps[t].reset(new rowSweep(numRows));
+        sweeps[t]->compute(A, i, d_low, d_up, *cols);
+        token.release(t);
+
+        return cols;
+      }
+
+      static std::size_t rowBytes(const std::vector<lno_t> &row)
+      {
+        //columns plus bookkeeping (list node, hash entry, shared state)
+        return row.size() * sizeof(lno_t) + 96;
+      }
+  };
+}
+
+#endif
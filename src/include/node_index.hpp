@@ -0,0 +1,289 @@
+/**
+ * @file    node_index.hpp
+ * @brief   valid-pairs index computed on the compacted (sequence-labeled) graph
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_NODE_INDEX_HPP
+#define PAIRG_NODE_INDEX_HPP
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+
+//External includes
+#include "PaSGAL/csr.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     index that answers per-character distance queries using the
+   *            original node graph (one row per vg node instead of one row
+   *            per base)
+   * @details   - edge u -> v of the node graph gets weight len(u); a walk from
+   *              base a of node u to base b of node v has length
+   *              W - a + b, where W is the weight of the node-level walk
+   *            - the index stores, for every node pair (u,v), the set of
+   *              distinct walk weights W <= d_up + len(u) - 1 (bounded-distance
+   *              semiring: union as addition, truncated minkowski sum as
+   *              multiplication)
+   *            - the closure is computed by repeated squaring S <- S + S*S
+   *              until no new (column, weight) entry appears; all edge weights
+   *              are >= 1, so at most log2(max bound) rounds are needed
+   *            - entries within a row are sorted by (column, weight)
+   *            - base ids are the ids used by CSR_char_container, i.e., bases
+   *              laid out node after node in the sorted node order
+   */
+  class nodeGraphIndex
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      //distance limits the index was built for
+      int d_low, d_up;
+
+      //count of nodes and bases
+      lno_t numNodes, numChars;
+
+      //first base id of each node, size = numNodes + 1
+      matrixOps::lno_nnz_view_t node_start;
+
+      //(column, weight) entries, row u spans [row_map(u), row_map(u+1))
+      matrixOps::lno_view_t row_map;
+      matrixOps::lno_nnz_view_t entries;
+      matrixOps::lno_nnz_view_t distances;
+
+      nodeGraphIndex() : d_low(0), d_up(0), numNodes(0), numChars(0) {}
+
+      /**
+       * @brief                 build index
+       * @param[in]   diGraph   sorted node graph (psgl::graphLoader::diGraph)
+       * @param[in]   p         input parameters (distance constraints)
+       */
+      void build(const psgl::CSR_container &diGraph, const Parameters &p)
+      {
+        d_low = p.d_low;
+        d_up = p.d_up;
+        numNodes = diGraph.numVertices;
+
+        node_start = matrixOps::lno_nnz_view_t ("node_start", numNodes + 1);
+        for(lno_t u = 0; u < numNodes; u++)
+          node_start(u + 1) = node_start(u) + diGraph.vertex_metadata[u].length();
+        numChars = node_start(numNodes);
+
+        //weighted adjacency matrix: (v, len(u)) for each edge u -> v
+        row_map = matrixOps::lno_view_t ("row_map", numNodes + 1);
+        Kokkos::parallel_for("pairg::nodeGraphIndex::adjacency", range_type(0, numNodes), [&](const lno_t u)
+        {
+          row_map(u + 1) = nodeLength(u) <= rowBound(u) ? diGraph.offsets_out[u+1] - diGraph.offsets_out[u] : 0;
+        });
+        size_type nnz = matrixOps::prefixSum(row_map);
+
+        entries = matrixOps::lno_nnz_view_t ("entries", nnz);
+        distances = matrixOps::lno_nnz_view_t ("distances", nnz);
+        Kokkos::parallel_for("pairg::nodeGraphIndex::adjacency", range_type(0, numNodes), [&](const lno_t u)
+        {
+          for(size_type k = 0; k < row_map(u + 1) - row_map(u); k++)
+          {
+            entries(row_map(u) + k) = diGraph.adjcny_out[diGraph.offsets_out[u] + k];
+            distances(row_map(u) + k) = nodeLength(u);
+          }
+        });
+        sortRows();
+
+        //S <- S + S*S until fixed point
+        for(int round = 1; ; round++)
+        {
+          pairg::timer T;
+          size_type prev_nnz = entries.extent(0);
+
+          squareAndAdd();
+
+          std::cout << "INFO, pairg::nodeGraphIndex::build, round " << round << ", nnz = " << entries.extent(0) << ", time (ms): " << T.elapsed() << "\n";
+
+          if (entries.extent(0) == prev_nnz)
+            break;
+        }
+
+        //drop weights too small to satisfy d_low from any base pair
+        filterEntries([&](lno_t v, lno_t W) { return W + nodeLength(v) - 1 >= d_low; });
+      }
+
+      /**
+       * @brief                 query whether a path of length in [d_low, d_up] exists
+       *                        from base i to base j
+       * @note                  base ids should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j) const
+      {
+        if (i >= numChars || j >= numChars) {
+          std::cout << "WARNING, pairg::nodeGraphIndex::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        lno_t u = nodeOf(i), v = nodeOf(j);
+        lno_t a = i - node_start(u), b = j - node_start(v);
+
+        //path within a single node
+        if (u == v && b >= a && b - a >= d_low && b - a <= d_up)
+          return true;
+
+        lno_t lo = d_low + a - b;
+        lno_t hi = d_up + a - b;
+
+        //first entry >= (v, lo) in row u
+        size_type first = row_map(u), last = row_map(u + 1);
+        while (first < last)
+        {
+          size_type mid = first + (last - first) / 2;
+          if (entries(mid) < v || (entries(mid) == v && distances(mid) < lo))
+            first = mid + 1;
+          else
+            last = mid;
+        }
+
+        return first < row_map(u + 1) && entries(first) == v && distances(first) <= hi;
+      }
+
+      /**
+       * @brief                 node containing a base
+       */
+      lno_t nodeOf(lno_t i) const
+      {
+        return std::upper_bound(node_start.data(), node_start.data() + numNodes + 1, i) - node_start.data() - 1;
+      }
+
+      /**
+       * @brief                 print index properties to stdout
+       */
+      void printStats() const
+      {
+        std::cout << "INFO, pairg::nodeGraphIndex::printStats, nodes:" << numNodes << ", bases:" << numChars << "\n";
+        std::cout << "INFO, pairg::nodeGraphIndex::printStats, (column, weight) entries:" << entries.extent(0) << "\n";
+      }
+
+    private:
+
+      typedef std::vector< std::pair<lno_t, lno_t> > rowBuffer;
+
+      lno_t nodeLength(lno_t u) const
+      {
+        return node_start(u + 1) - node_start(u);
+      }
+
+      /**
+       * @brief                 largest walk weight that can matter for row u
+       */
+      lno_t rowBound(lno_t u) const
+      {
+        return d_up + nodeLength(u) - 1;
+      }
+
+      /**
+       * @brief                 sort entries within each row by (column, weight)
+       */
+      void sortRows()
+      {
+        Kokkos::parallel_for("pairg::nodeGraphIndex::sortRows", range_type(0, numNodes), [&](const lno_t u)
+        {
+          rowBuffer buf;
+          for(size_type k = row_map(u); k < row_map(u + 1); k++)
+            buf.emplace_back(entries(k), distances(k));
+
+          std::sort(buf.begin(), buf.end());
+
+          for(size_type k = row_map(u); k < row_map(u + 1); k++)
+            std::tie(entries(k), distances(k)) = buf[k - row_map(u)];
+        });
+      }
+
+      /**
+       * @brief                 rebuild rows from a per-row generator in two phases
+       *                        (count, prefix sum, fill)
+       * @param[in] collectRow  functor (u, buffer) that writes sorted, distinct
+       *                        (column, weight) entries of row u into buffer
+       */
+      template <typename RowFn>
+        void rebuild(const RowFn &collectRow)
+        {
+          Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+          std::vector<rowBuffer> buffers (token.size());
+
+          matrixOps::lno_view_t row_map_new ("row_map", numNodes + 1);
+
+          Kokkos::parallel_for("pairg::nodeGraphIndex::rebuild::symbolic", range_type(0, numNodes), [&](const lno_t u)
+          {
+            int t = token.acquire();
+            collectRow(u, buffers[t]);
+            row_map_new(u + 1) = buffers[t].size();
+            token.release(t);
+          });
+
+          size_type nnz = matrixOps::prefixSum(row_map_new);
+          matrixOps::lno_nnz_view_t entries_new (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+          matrixOps::lno_nnz_view_t distances_new (Kokkos::ViewAllocateWithoutInitializing("distances"), nnz);
+
+          Kokkos::parallel_for("pairg::nodeGraphIndex::rebuild::numeric", range_type(0, numNodes), [&](const lno_t u)
+          {
+            int t = token.acquire();
+            collectRow(u, buffers[t]);
+            for(std::size_t k = 0; k < buffers[t].size(); k++)
+              std::tie(entries_new(row_map_new(u) + k), distances_new(row_map_new(u) + k)) = buffers[t][k];
+            token.release(t);
+          });
+
+          row_map = row_map_new;
+          entries = entries_new;
+          distances = distances_new;
+        }
+
+      /**
+       * @brief                 S <- S + S*S, truncated at rowBound() of each row
+       */
+      void squareAndAdd()
+      {
+        auto collectRow = [&](const lno_t u, rowBuffer &buf)
+        {
+          buf.clear();
+          lno_t bound = rowBound(u);
+
+          for(size_type k1 = row_map(u); k1 < row_map(u + 1); k1++)
+          {
+            lno_t w = entries(k1), W1 = distances(k1);
+            buf.emplace_back(w, W1);
+
+            for(size_type k2 = row_map(w); k2 < row_map(w + 1); k2++)
+              if (W1 + distances(k2) <= bound)
+                buf.emplace_back(entries(k2), W1 + distances(k2));
+          }
+
+          std::sort(buf.begin(), buf.end());
+          buf.erase(std::unique(buf.begin(), buf.end()), buf.end());
+        };
+
+        rebuild(collectRow);
+      }
+
+      /**
+       * @brief                 keep only entries (v, W) satisfying a predicate
+       */
+      template <typename Pred>
+        void filterEntries(const Pred &keep)
+        {
+          auto collectRow = [&](const lno_t u, rowBuffer &buf)
+          {
+            buf.clear();
+
+            for(size_type k = row_map(u); k < row_map(u + 1); k++)
+              if (keep(entries(k), distances(k)))
+                buf.emplace_back(entries(k), distances(k));
+          };
+
+          rebuild(collectRow);
+        }
+  };
+}
+
+#endif
@@ -7,6 +7,9 @@
 #ifndef PAIRG_PARSE_CMD_HPP 
 #define PAIRG_PARSE_CMD_HPP
 
+#include <cstdio>
+#include <vector>
+
 //External includes
 #include "clipp/include/clipp.h"
 
@@ -19,11 +22,20 @@ namespace pairg
   {
     std::string graphfile;      //variation graph file
     std::string gmode;          //variation graph input format
+    std::string iformat;        //index format used for querying
+    std::string indexfile;      //file to save index to
+    std::string vorder;         //vertex order used for building the index
 
     int d_low;                  //lower bound on path length
     int d_up;                   //upper bound on path length
     int threads;                //threads for parallel execution
     int querycount;             //count of distance queries to run
+    int budget;                 //memory budget (MB) for out-of-core index build, or per block with -k; 0 if disabled
+    int cachesize;              //memory limit (MB) of the row cache of the lazy index
+    bool sortqueries;           //group query batch by source vertex
+    bool components;            //build index per weakly connected component
+
+    std::vector< std::pair<int,int> > windows;    //all distance windows, [d_low, d_up] first
   };
 
   /**
@@ -34,16 +46,48 @@ namespace pairg
    **/
   void parseandSave(int argc, char** argv, pairg::Parameters &param)
   {
+    //defaults for optional arguments
+    param.iformat = "csr";
+    param.vorder = "none";
+    param.budget = 0;
+    param.cachesize = 1024;
+    param.sortqueries = false;
+    param.components = false;
+
+    std::vector<std::string> windowspec;
+
     auto cli = 
       (
        clipp::required("-r") & clipp::value("file", param.graphfile).doc("variation graph file"),
        clipp::required("-m") & 
             (clipp::required("vg").set(param.gmode) | 
-            clipp::required("txt").set(param.gmode)).doc("variation graph format"),
+            clipp::required("txt").set(param.gmode) | 
+            clipp::required("gfa").set(param.gmode)).doc("variation graph format"),
        clipp::required("-c") & clipp::value("qcount", param.querycount).doc("count of distance queries"),
        clipp::required("-l") & clipp::value("d1", param.d_low).doc("lower bound on path length"),
        clipp::required("-u") & clipp::value("d2", param.d_up).doc("upper bound on path length"),
-       clipp::required("-t") & clipp::value("threads", param.threads).doc("count of threads for parallel execution")
+       clipp::required("-t") & clipp::value("threads", param.threads).doc("count of threads for parallel execution"),
+       clipp::option("-f") & 
+            (clipp::required("csr").set(param.iformat) | 
+            clipp::required("hybrid").set(param.iformat) | 
+            clipp::required("node").set(param.iformat) | 
+            clipp::required("interval").set(param.iformat) | 
+            clipp::required("compressed").set(param.iformat) | 
+            clipp::required("eytzinger").set(param.iformat) | 
+            clipp::required("distance").set(param.iformat) | 
+            clipp::required("lazy").set(param.iformat) | 
+            clipp::required("bfs").set(param.iformat)).doc("index format used for querying [csr]"),
+       clipp::option("-p") & 
+            (clipp::required("none").set(param.vorder) | 
+            clipp::required("rcm").set(param.vorder) | 
+            clipp::required("bfs").set(param.vorder) | 
+            clipp::required("topo").set(param.vorder)).doc("vertex order used for building the index [none]"),
+       clipp::option("-o") & clipp::value("file", param.indexfile).doc("index file, loaded if built for the same graph and distance limits, saved otherwise (suffixed .d1-d2 per window with -w)"),
+       clipp::option("-b") & clipp::value("MB", param.budget).doc("memory budget for building index out of core (requires -o), or for each block with -k"),
+       clipp::option("-e") & clipp::value("MB", param.cachesize).doc("row cache size of lazy index [1024]"),
+       clipp::option("-s").set(param.sortqueries).doc("group distance queries by source vertex before answering"),
+       clipp::option("-k").set(param.components).doc("build index independently per weakly connected component"),
+       clipp::option("-w") & clipp::values("d1:d2", windowspec).doc("additional distance windows, indexed with one build")
       );
 
     if(!clipp::parse(argc, argv, cli)) 
@@ -56,10 +100,80 @@ namespace pairg
     omp_set_num_threads(param.threads);
     assert (param.d_up >= param.d_low);
 
+    //index formats built directly from the graph (or no index at all), not from a valid-pairs pattern
+    bool graphOnly = param.iformat.compare("node") == 0 || param.iformat.compare("distance") == 0 || param.iformat.compare("lazy") == 0 || param.iformat.compare("bfs") == 0;
+
+    param.windows.emplace_back(param.d_low, param.d_up);
+    for(auto &w : windowspec)
+    {
+      int d1, d2;
+      char rest;
+      if (std::sscanf(w.c_str(), "%d:%d%c", &d1, &d2, &rest) != 2 || d1 < 0 || d2 < d1)
+      {
+        std::cerr << "ERROR, pairg::parseandSave, invalid distance window " << w << ", expected d1:d2 with 0 <= d1 <= d2" << std::endl;
+        exit(1);
+      }
+      param.windows.emplace_back(d1, d2);
+    }
+
+    if (param.components && (graphOnly || param.windows.size() > 1))
+    {
+      std::cout << "WARNING, pairg::parseandSave, per-component build is not supported with " << (graphOnly ? param.iformat + " index format" : "multiple distance windows") << ", ignoring -k" << std::endl;
+      param.components = false;
+    }
+
+    //with -k, the budget sizes the blocks instead of selecting an out-of-core build
+    bool outOfCore = param.budget > 0 && !param.components;
+
+    if (param.windows.size() > 1 && (graphOnly || outOfCore))
+    {
+      std::cerr << "ERROR, pairg::parseandSave, multiple distance windows (-w) are not supported for " << (outOfCore ? "out-of-core builds" : param.iformat + " index format") << std::endl;
+      exit(1);
+    }
+
+    if (outOfCore && param.indexfile.empty())
+    {
+      std::cerr << "ERROR, pairg::parseandSave, out-of-core build (-b) requires an index file (-o)" << std::endl;
+      exit(1);
+    }
+
+    if (!param.indexfile.empty() && graphOnly)
+    {
+      std::cout << "WARNING, pairg::parseandSave, index file is not supported for " << param.iformat << " index format, ignoring -o" << std::endl;
+      param.indexfile.clear();
+      param.budget = 0;
+    }
+
+    if (param.iformat.compare("node") == 0 && param.gmode.compare("gfa") == 0)
+    {
+      std::cerr << "ERROR, pairg::parseandSave, node index format requires vg or txt input" << std::endl;
+      exit(1);
+    }
+
+    if (param.iformat.compare("node") == 0 && param.vorder.compare("none") != 0)
+    {
+      std::cout << "WARNING, pairg::parseandSave, vertex order is not supported for node index format, ignoring -p" << std::endl;
+      param.vorder = "none";
+    }
+
     std::cout << "INFO, pairg::parseandSave, reference graph = " << param.graphfile << std::endl;
-    std::cout << "INFO, pairg::parseandSave, limits = [" << param.d_low << ", " << param.d_up << "]" << std::endl;
+    for(auto &w : param.windows)
+      std::cout << "INFO, pairg::parseandSave, limits = [" << w.first << ", " << w.second << "]" << std::endl;
     std::cout << "INFO, pairg::parseandSave, thread count = " << param.threads << std::endl;
     std::cout << "INFO, pairg::parseandSave, distance query count = " << param.querycount << std::endl;
+    std::cout << "INFO, pairg::parseandSave, index format = " << param.iformat << std::endl;
+    std::cout << "INFO, pairg::parseandSave, vertex order = " << param.vorder << std::endl;
+    std::cout << "INFO, pairg::parseandSave, group queries by source = " << (param.sortqueries ? "yes" : "no") << std::endl;
+    std::cout << "INFO, pairg::parseandSave, build per component = " << (param.components ? "yes" : "no") << std::endl;
+
+    if (!param.indexfile.empty())
+      std::cout << "INFO, pairg::parseandSave, index file = " << param.indexfile << std::endl;
+
+    if (param.budget > 0)
+      std::cout << "INFO, pairg::parseandSave, " << (param.components ? "memory budget per block" : "out-of-core memory budget") << " (MB) = " << param.budget << std::endl;
+
+    if (param.iformat.compare("lazy") == 0)
+      std::cout << "INFO, pairg::parseandSave, row cache size (MB) = " << param.cachesize << std::endl;
   }
 }
 
@@ -0,0 +1,290 @@
+/**
+ * @file    query_planner.hpp
+ * @brief   per-query choice between index lookup and bounded search
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_QUERY_PLANNER_HPP
+#define PAIRG_QUERY_PLANNER_HPP
+
+#include <chrono>
+#include <memory>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+#include "heuristics.hpp"
+#include "lazy_index.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     query front-end over whatever is available: a complete index,
+   *            a lazy index, or only the adjacency pattern
+   * @details   - acyclic graph: a target before the source in topological order
+   *              is rejected without touching index or graph
+   *            - complete index, in any row format: always looked up
+   *            - lazy index: a cached row is looked up; on a miss, the row is
+   *              computed into the cache only if its predicted cost, amortized
+   *              over the expected future queries on the row, is below the
+   *              predicted cost of a bounded search; rows seen for the first
+   *              time are searched
+   *            - expected future queries on a row are estimated by its count
+   *              of earlier queries, i.e., a row queried k times so far is
+   *              assumed to be queried about k more times (no decay; rows hot
+   *              only early in a workload may be built late or needlessly)
+   *            - predicted cost = work estimate from out-degree of the source,
+   *              in-degree of the target and window size, times the measured
+   *              time per unit of work of the strategy
+   *            - timing is sampled, per-strategy counters are printed by
+   *              printStats; counters and measured costs are kept per thread,
+   *              so concurrent queries do not share a cache line
+   */
+  class queryPlanner
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+
+      enum strategy { ORDER, LOOKUP, CACHED_ROW, BUILD_ROW, SEARCH, STRATEGY_COUNT };
+
+      //count of vertices
+      lno_t numVertices;
+
+      /**
+       * @brief                 plan over the adjacency pattern only
+       * @param[in]   A         sparsity pattern of graph adjacency matrix, kept by reference
+       * @param[in]   p         input parameters (distance constraints)
+       */
+      queryPlanner(const matrixOps::graph_t &A, const Parameters &p)
+        : queryPlanner(A, p, nullptr, nullptr)
+      {}
+
+      /**
+       * @brief                 plan with a complete valid-pairs index, kept by reference
+       */
+      queryPlanner(const matrixOps::graph_t &A, const Parameters &p, const matrixOps::graph_t &index)
+        : queryPlanner(A, p, &index, nullptr)
+      {
+        if (index.numRows() != A.numRows())
+        {
+          std::cerr << "ERROR, pairg::queryPlanner, index has " << index.numRows() << " rows, graph has " << A.numRows() << " vertices" << std::endl;
+          exit(1);
+        }
+      }
+
+      /**
+       * @brief                 plan with a lazy index, kept by reference
+       */
+      queryPlanner(const matrixOps::graph_t &A, const Parameters &p, lazyIndex &lazy)
+        : queryPlanner(A, p, nullptr, &lazy)
+      {}
+
+      /**
+       * @brief                 plan with a complete index in any row format, without
+       *                        the adjacency pattern; queries are answered by
+       *                        queryValue(i, j, lookup)
+       * @param[in]   B         valid-pairs pattern the index was built from, only
+       *                        its shape is used: if no entry lies below the
+       *                        diagonal, targets before the source are rejected
+       */
+      queryPlanner(const Parameters &p, const matrixOps::graph_t &B)
+        : numVertices(B.numRows()), index(nullptr), lazy(nullptr), acyclic(noEntryBelowDiagonal(B)), window(p.d_up + 1.0), stats(token.size())
+      {}
+
+      /**
+       * @brief                 query value at given coordinates from a complete index
+       * @param[in]   lookup    functor (i, j) answering from the index
+       * @note                  row and column indices should be 0-based
+       */
+      template <typename LookupFn>
+      bool queryValue(lno_t i, lno_t j, const LookupFn &lookup)
+      {
+        if (i >= numVertices || j >= numVertices) {
+          std::cout << "WARNING, pairg::queryPlanner::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        if (acyclic && j < i)
+          return run(ORDER, 1, [&]() { return false; });
+
+        return run(LOOKUP, 1, [&]() { return lookup(i, j); });
+      }
+
+      /**
+       * @brief                 query value at given coordinates
+       * @note                  row and column indices should be 0-based
+       */
+      bool queryValue(lno_t i, lno_t j)
+      {
+        if (index)
+          return queryValue(i, j, [&](lno_t u, lno_t v) { return matrixOps::queryValue(*index, u, v); });
+
+        if (i >= numVertices || j >= numVertices) {
+          std::cout << "WARNING, pairg::queryPlanner::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        if (acyclic && j < i)
+          return run(ORDER, 1, [&]() { return false; });
+
+        if (lazy)
+        {
+          lazyIndex::row_ptr row = lazy->findRow(i);
+          if (row)
+            return run(CACHED_ROW, 1, [&]() { return std::binary_search(row->begin(), row->end(), j); });
+
+          //count of earlier queries on this row, taken as the expected count of later ones
+          unsigned int demand = Kokkos::atomic_fetch_add(&rowDemand(i), 1u);
+
+          double buildWork = (search->outDegree(i) + 1.0) * window;
+          double searchWork = (search->outDegree(i) + search->inDegree(j) + 1.0) * window;
+
+          if (demand > 0 && predict(BUILD_ROW, buildWork) / demand < predict(SEARCH, searchWork))
+            return run(BUILD_ROW, buildWork, [&]() { return lazy->queryValue(i, j); });
+
+          return run(SEARCH, searchWork, [&]() { return search->queryValue(i, j); });
+        }
+
+        return run(SEARCH, 1, [&]() { return search->queryValue(i, j); });
+      }
+
+      /**
+       * @brief                 count of queries answered by strategy s
+       */
+      uint64_t queries(strategy s) const
+      {
+        uint64_t count = 0;
+        for(auto &t : stats)
+          count += t.s[s].count;
+        return count;
+      }
+
+      /**
+       * @brief                 print per-strategy counters to stdout
+       */
+      void printStats() const
+      {
+        static const char *names[STRATEGY_COUNT] = {"topological order", "index lookup", "cached row", "row build", "bounded search"};
+
+        for(int s = 0; s < STRATEGY_COUNT; s++)
+        {
+          strategyStats total;
+          for(auto &t : stats)
+          {
+            total.count += t.s[s].count;
+            total.samples += t.s[s].samples;
+            total.nanos += t.s[s].nanos;
+          }
+
+          if (total.count > 0)
+            std::cout << "INFO, pairg::queryPlanner::printStats, " << names[s] << ": queries = " << total.count
+              << ", avg time (ns) = " << (total.samples > 0 ? (double) total.nanos / total.samples : 0.0) << "\n";
+        }
+      }
+
+    private:
+
+      struct strategyStats
+      {
+        uint64_t count = 0;
+
+        //sampled queries
+        uint64_t samples = 0;
+        uint64_t nanos = 0;
+        uint64_t work = 0;
+      };
+
+      //counters of one thread, padded to keep threads off each other's cache lines
+      struct threadStats
+      {
+        strategyStats s[STRATEGY_COUNT];
+        char padding[64];
+      };
+
+      //time one of every sampleRate queries per strategy
+      static uint64_t sampleRate() { return 16; }
+
+      //samples needed before measured cost replaces the default of 1 ns per unit of work
+      static uint64_t minSamples() { return 32; }
+
+      const matrixOps::graph_t *index;
+      lazyIndex *lazy;
+      std::unique_ptr<boundedSearch> search;
+
+      //no valid pair (i, j) with j < i, e.g., vertex ids are a topological order of an acyclic graph
+      bool acyclic;
+
+      //d_up + 1, frontier levels expanded by a row build or a search
+      double window;
+
+      Kokkos::View<unsigned int*, matrixOps::Device> rowDemand;
+
+      Kokkos::Experimental::UniqueToken<matrixOps::Device::execution_space> token;
+      std::vector<threadStats> stats;
+
+      queryPlanner(const matrixOps::graph_t &A, const Parameters &p, const matrixOps::graph_t *index, lazyIndex *lazy)
+        : numVertices(A.numRows()), index(index), lazy(lazy), acyclic(matrixOps::isUpperTriangular(A)), window(p.d_up + 1.0), stats(token.size())
+      {
+        //search engine is not needed with a complete index
+        if (!index)
+          search.reset(new boundedSearch(A, p));
+
+        if (lazy)
+          rowDemand = Kokkos::View<unsigned int*, matrixOps::Device>("rowDemand", numVertices);
+      }
+
+      /**
+       * @brief                 check that every row starts at or after the diagonal,
+       *                        rows are assumed sorted
+       */
+      static bool noEntryBelowDiagonal(const matrixOps::graph_t &B)
+      {
+        matrixOps::size_type below = 0;
+
+        Kokkos::parallel_reduce("pairg::queryPlanner::noEntryBelowDiagonal", matrixOps::range_type(0, B.numRows()), [&](const lno_t i, matrixOps::size_type &update)
+        {
+          if (B.row_map(i) < B.row_map(i+1) && B.entries(B.row_map(i)) < i)
+            update++;
+        }, below);
+
+        return below == 0;
+      }
+
+      //cost measured by the calling thread
+      double predict(strategy s, double work)
+      {
+        int t = token.acquire();
+        const strategyStats &st = stats[t].s[s];
+        double nsPerWork = st.samples >= minSamples() && st.work > 0 ? (double) st.nanos / st.work : 1.0;
+        token.release(t);
+
+        return nsPerWork * work;
+      }
+
+      template <typename Fn>
+      bool run(strategy s, double work, const Fn &fn)
+      {
+        int t = token.acquire();
+        strategyStats &st = stats[t].s[s];
+        bool value;
+
+        if (st.count++ % sampleRate() != 0)
+          value = fn();
+        else
+        {
+          auto start = std::chrono::steady_clock::now();
+          value = fn();
+          auto stop = std::chrono::steady_clock::now();
+
+          st.nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+          st.work += (uint64_t) work;
+          st.samples++;
+        }
+
+        token.release(t);
+        return value;
+      }
+  };
+}
+
+#endif
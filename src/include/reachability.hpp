@@ -8,6 +8,9 @@
 
 #include "spgemm_utility.hpp"
 #include "parseCmdArgs.hpp"
+#include "index_file.hpp"
+#include "dag_builder.hpp"
+#include "graph_ingest.hpp"
 
 //External includes
 #include "PaSGAL/graphLoad.hpp"
@@ -15,78 +18,274 @@
 namespace pairg
 {
   /**
-   * @brief     build adjacency matrix from variaton graph
+   * @brief     load variation graph in the format specified by user
    */
-  matrixOps::crsMat_t getAdjacencyMatrix(const Parameters &parameters) 
+  void loadGraph(const Parameters &parameters, psgl::graphLoader &g)
   {
-    psgl::graphLoader g;
+    if (parameters.gmode.compare("vg") == 0)
+      g.loadFromVG(parameters.graphfile);
+    else if(parameters.gmode.compare("txt") == 0)
+      g.loadFromTxt(parameters.graphfile);
+    else 
     {
-      if (parameters.gmode.compare("vg") == 0)
-        g.loadFromVG(parameters.graphfile);
-      else if(parameters.gmode.compare("txt") == 0)
-        g.loadFromTxt(parameters.graphfile);
-      else 
-      {
-        std::cerr << "Invalid graph format " << parameters.gmode << std::endl;
-        exit(1);
-      }
+      std::cerr << "Invalid graph format " << parameters.gmode << std::endl;
+      exit(1);
     }
+  }
 
+  /**
+   * @brief     build sparsity pattern of adjacency matrix from a loaded variaton graph
+   * @details   only row_map and entries are built, no values array
+   */
+  matrixOps::graph_t getAdjacencyGraph(const psgl::graphLoader &g) 
+  {
     //Use g.diCharGraph to build crsMat_t matrix
     typename matrixOps::lno_t nrows = g.diCharGraph.numVertices;
     typename matrixOps::size_type nnz = g.diCharGraph.numEdges;
 
-    typename matrixOps::lno_nnz_view_t entries("entries", nnz);
-    typename matrixOps::scalar_view_t values("values", nnz);
-    typename matrixOps::lno_view_t rowmap("rowmap", nrows + 1);
-
-    for(matrixOps::size_type i = 0; i < nnz; i++) {
-      values(i) = 1;  //boolean
-    }
+    typename matrixOps::lno_nnz_view_t entries(Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+    typename matrixOps::lno_view_t rowmap(Kokkos::ViewAllocateWithoutInitializing("rowmap"), nrows + 1);
 
-    for(matrixOps::size_type i = 0; i < nnz; i++) {
+    Kokkos::parallel_for("pairg::getAdjacencyGraph::entries", matrixOps::range_type(0, nnz), [&](const matrixOps::size_type i)
+    {
       entries(i) = g.diCharGraph.adjcny_out[i];
-    }
+    });
 
-    for(matrixOps::lno_t i = 0; i < nrows + 1; i++) {
+    Kokkos::parallel_for("pairg::getAdjacencyGraph::rowmap", matrixOps::range_type(0, nrows + 1), [&](const matrixOps::lno_t i)
+    {
       rowmap(i) = g.diCharGraph.offsets_out[i];
-    }
+    });
 
-    return matrixOps::crsMat_t("adjacency matrix", nrows, nrows, nnz, values, rowmap, entries);
+    return matrixOps::graph_t(entries, rowmap);
   }
 
   /**
-   * @brief           build matrix associated with valid vertices that satisfy 
-   *                  distance constraints
-   * @param[in] A     graph adjacency matrix
-   * @return          validity matrix
-   *                  cell (i,j) = 1 iff there is a valid path from v_i to v_j
+   * @brief     build sparsity pattern of adjacency matrix from variaton graph
+   * @details   only row_map and entries are built, no values array
    */
-  matrixOps::crsMat_t buildValidPairsMatrix(const matrixOps::crsMat_t &A, const Parameters &p)
+  matrixOps::graph_t getAdjacencyGraph(const Parameters &parameters) 
+  {
+    //graph file is parsed once, straight into the pattern; the parser
+    //accepts only these three formats
+    if (parameters.gmode.compare("vg") == 0)
+      return ingestVG(parameters.graphfile);
+    else if (parameters.gmode.compare("txt") == 0)
+      return ingestTxt(parameters.graphfile);
+    else
+      return ingestGFA(parameters.graphfile);
+  }
+
+  /**
+   * @brief     build adjacency matrix from variaton graph
+   */
+  matrixOps::crsMat_t getAdjacencyMatrix(const Parameters &parameters) 
+  {
+    return matrixOps::graphToMatrix(getAdjacencyGraph(parameters), "adjacency matrix");
+  }
+
+  /**
+   * @brief           compute two factors of the valid-pairs pattern
+   * @param[in] A     sparsity pattern of graph adjacency matrix
+   * @param[out] C, D C * D = A^d_low * (A+I)^(d_up-d_low), D is left empty if
+   *                  a single factor remains (see matrixOps::multiplyFactors)
+   * @details         both powers are evaluated with one combined schedule, 
+   *                  see matrixOps::powerFactors
+   */
+  void buildValidPairsFactors(const matrixOps::graph_t &A, const Parameters &p, matrixOps::graph_t &C, matrixOps::graph_t &D)
   {
+    std::vector<matrixOps::powerTerm> terms;
+
     pairg::timer T1;
-    matrixOps::crsMat_t B = matrixOps::addMatrices(A, matrixOps::createIdentityMatrix(A.numRows()));
-    std::cout << "INFO, pairg::buildValidPairsMatrix, time to add identity matrix (ms): " << T1.elapsed() << "\n";
+    terms.emplace_back(A, p.d_low);
+    terms.emplace_back(matrixOps::addGraphs(A, matrixOps::createIdentityGraph(A.numRows())), p.d_up - p.d_low);
+    std::cout << "INFO, pairg::buildValidPairsFactors, time to add identity matrix (ms): " << T1.elapsed() << "\n";
 
     pairg::timer T2;
-    matrixOps::crsMat_t C = matrixOps::power(A, p.d_low);
-    std::cout << "INFO, pairg::buildValidPairsMatrix, time to raise adjacency matrix (ms): " << T2.elapsed() << "\n";
+    matrixOps::powerFactors(std::move(terms), A.numRows(), C, D);
+    std::cout << "INFO, pairg::buildValidPairsFactors, time to raise adjacency and adjacency+identity matrices (ms): " << T2.elapsed() << "\n";
+  }
 
-    pairg::timer T3;
-    matrixOps::crsMat_t D = matrixOps::power (B, p.d_up - p.d_low);
-    std::cout << "INFO, pairg::buildValidPairsMatrix, time to raise adjacency+identity matrix (ms): " << T3.elapsed() << "\n";
+  /**
+   * @brief           build sparsity pattern of valid vertex pairs that satisfy 
+   *                  distance constraints
+   * @param[in] A     sparsity pattern of graph adjacency matrix
+   * @return          validity pattern, entries within each row are sorted
+   *                  cell (i,j) is present iff there is a valid path from v_i to v_j
+   * @details         - structure-only (boolean) counterpart of buildValidPairsMatrix,
+   *                    no values array is carried through the computation
+   *                  - acyclic graphs use a topological sweep instead of matrix
+   *                    powers when it is expected to be cheaper
+   */
+  matrixOps::graph_t buildValidPairsGraph(const matrixOps::graph_t &A, const Parameters &p)
+  {
+    //vertex ids of an acyclic graph are topologically sorted by the loader
+    if (preferTopologicalSweep(A, p))
+      return buildValidPairsGraphDAG(A, p);
 
-    pairg::timer T4;
-    matrixOps::crsMat_t E = matrixOps::multiplyMatrices(C,D); 
-    std::cout << "INFO, pairg::buildValidPairsMatrix, time to execute final multiplication (ms): " << T4.elapsed() << "\n";
+    matrixOps::graph_t C, D;
+    buildValidPairsFactors(A, p, C, D);
 
-    //sort entries within each row
-    pairg::timer T5;
-    matrixOps::indexForQuery(E); 
-    std::cout << "INFO, pairg::buildValidPairsMatrix, time to index for querying (ms): " << T5.elapsed() << "\n";
+    //rows of the product are emitted sorted, no separate indexing pass required
+    pairg::timer T4;
+    matrixOps::graph_t E = matrixOps::multiplyFactors(C,D); 
+    std::cout << "INFO, pairg::buildValidPairsGraph, time to execute final multiplication (ms): " << T4.elapsed() << "\n";
 
     return E;
   }
+
+  /**
+   * @brief           build sparsity patterns of valid vertex pairs for several
+   *                  distance windows with one build
+   * @param[in] A     sparsity pattern of graph adjacency matrix
+   * @param[in] windows   distance windows (d_low, d_up)
+   * @param[in] visit functor (k, pattern) called for window k as soon as its
+   *                  pattern is ready, i.e., only one pattern is held at a time
+   * @details         - repeated squarings of A and A+I are computed once and 
+   *                    shared by all windows (see matrixOps::squareCache)
+   *                  - each window then costs popcount(d_low) + popcount(d_up-d_low) - 1
+   *                    multiplications, including the final one
+   *                  - after each window, squares needed by none of the remaining
+   *                    windows are released (see matrixOps::squareCache::release)
+   *                  - like buildValidPairsGraph, a window of an acyclic graph takes
+   *                    the topological sweep when it is expected to be cheaper;
+   *                    squares are computed on demand, so none are formed if every
+   *                    window takes the sweep
+   */
+  template <typename VisitFn>
+    void buildValidPairsGraphs(const matrixOps::graph_t &A, const std::vector< std::pair<int,int> > &windows, const VisitFn &visit)
+    {
+      pairg::timer T1;
+      matrixOps::squareCache powA (A);
+      matrixOps::squareCache powAI (matrixOps::addGraphs(A, matrixOps::createIdentityGraph(A.numRows())));
+      std::cout << "INFO, pairg::buildValidPairsGraphs, time to add identity matrix (ms): " << T1.elapsed() << "\n";
+
+      int spgemm_calls = 0;
+
+      //exponent bits of windows k, k+1, ...
+      std::vector<int> bitsA (windows.size() + 1, 0), bitsAI (windows.size() + 1, 0);
+      for(std::size_t k = windows.size(); k-- > 0; )
+      {
+        bitsA[k] = bitsA[k+1] | windows[k].first;
+        bitsAI[k] = bitsAI[k+1] | (windows[k].second - windows[k].first);
+      }
+
+      for(std::size_t k = 0; k < windows.size(); k++)
+      {
+        pairg::timer T2;
+
+        Parameters window;
+        std::tie(window.d_low, window.d_up) = windows[k];
+
+        if (preferTopologicalSweep(A, window))
+        {
+          matrixOps::graph_t E = buildValidPairsGraphDAG(A, window);
+          std::cout << "INFO, pairg::buildValidPairsGraphs, window [" << windows[k].first << ", " << windows[k].second << "], topological sweep, time (ms): " << T2.elapsed() << "\n";
+
+          powA.release(bitsA[k+1]);
+          powAI.release(bitsAI[k+1]);
+          visit(k, E);
+          continue;
+        }
+
+        std::vector< std::pair<matrixOps::squareCache*, int> > terms;
+        terms.emplace_back(&powA, windows[k].first);
+        terms.emplace_back(&powAI, windows[k].second - windows[k].first);
+
+        matrixOps::graph_t C, D;
+        spgemm_calls += matrixOps::powerFactors(terms, A.numRows(), C, D);
+        powA.release(bitsA[k+1]);
+        powAI.release(bitsAI[k+1]);
+        matrixOps::graph_t E = matrixOps::multiplyFactors(C, D);
+        spgemm_calls += !matrixOps::missingFactor(D);
+
+        std::cout << "INFO, pairg::buildValidPairsGraphs, window [" << windows[k].first << ", " << windows[k].second << "], time (ms): " << T2.elapsed() << "\n";
+
+        visit(k, E);
+      }
+
+      std::cout << "INFO, pairg::buildValidPairsGraphs, SpGEMM calls = " << powA.spgemm_calls + powAI.spgemm_calls + spgemm_calls << " for " << windows.size() << " windows" << std::endl;
+    }
+
+  /**
+   * @brief               build valid-pairs pattern out of core, under a memory budget
+   * @param[in] A         sparsity pattern of graph adjacency matrix
+   * @param[in] budget    memory budget (bytes) for output entries held in memory
+   * @param[in] filename  index file to write (see indexFileHeader)
+   * @param[in] toNew     vertex permutation, required iff p asks for reordered vertices
+   * @details             - the final multiplication C * D is split into panels of 
+   *                        consecutive rows of C, each sized so that its entries fit
+   *                        the budget (a panel holds at least one row)
+   *                      - a symbolic pass over all rows fixes the row map first,
+   *                        then panels are computed one after another and appended 
+   *                        to the file
+   *                      - use mappedIndex to query the result without loading it
+   *                      - never takes the topological sweep of an acyclic graph
+   *                        (buildValidPairsGraphDAG), which holds every row of the
+   *                        pattern in memory until the end
+   */
+  void buildValidPairsOutOfCore(const matrixOps::graph_t &A, const Parameters &p, std::size_t budget, const std::string &filename, const matrixOps::lno_nnz_view_t &toNew = matrixOps::lno_nnz_view_t())
+  {
+    matrixOps::graph_t C, D;
+    buildValidPairsFactors(A, p, C, D);
+
+    matrixOps::lno_t nrows = C.numRows();
+
+    //symbolic pass
+    pairg::timer T1;
+    matrixOps::lno_view_t row_map ("row_map", nrows + 1);
+    matrixOps::forEachProductRow(C, D, [&](const matrixOps::lno_t i, const std::vector<matrixOps::lno_t> &cols)
+    {
+      row_map(i + 1) = cols.size();
+    }, "pairg::buildValidPairsOutOfCore::symbolic");
+    matrixOps::size_type nnz = matrixOps::prefixSum(row_map);
+    std::cout << "INFO, pairg::buildValidPairsOutOfCore, time to count entries (ms): " << T1.elapsed() << ", nnz = " << nnz << "\n";
+
+    indexFileHeader meta (p);
+    indexFileWriter writer (filename, row_map, meta);
+
+    //numeric pass, one row panel at a time
+    pairg::timer T2;
+    const matrixOps::size_type panel_capacity = std::max<std::size_t>(budget / sizeof(matrixOps::lno_t), 1);
+    int panels = 0;
+
+    for(matrixOps::lno_t row_begin = 0; row_begin < nrows; )
+    {
+      //largest panel that fits the budget, at least one row
+      matrixOps::lno_t row_end = std::upper_bound(row_map.data() + row_begin + 1, row_map.data() + nrows + 1, row_map(row_begin) + panel_capacity) - row_map.data() - 1;
+      row_end = std::max(row_end, row_begin + 1);
+
+      matrixOps::size_type offset = row_map(row_begin);
+      matrixOps::lno_nnz_view_t panel (Kokkos::ViewAllocateWithoutInitializing("panel"), row_map(row_end) - offset);
+
+      matrixOps::forEachProductRow(C, D, row_begin, row_end, [&](const matrixOps::lno_t i, const std::vector<matrixOps::lno_t> &cols)
+      {
+        std::copy(cols.begin(), cols.end(), panel.data() + row_map(i) - offset);
+      }, "pairg::buildValidPairsOutOfCore::numeric");
+
+      writer.append(panel.data(), panel.extent(0));
+
+      row_begin = row_end;
+      panels++;
+    }
+
+    if (meta.reordered())
+      writer.appendPermutation(toNew);
+    writer.close();
+    std::cout << "INFO, pairg::buildValidPairsOutOfCore, time to compute and write " << panels << " panels (ms): " << T2.elapsed() << "\n";
+  }
+
+  /**
+   * @brief           build matrix associated with valid vertices that satisfy 
+   *                  distance constraints
+   * @param[in] A     graph adjacency matrix
+   * @return          validity matrix
+   *                  cell (i,j) = 1 iff there is a valid path from v_i to v_j
+   * @details         computed on sparsity patterns only, see buildValidPairsGraph
+   */
+  matrixOps::crsMat_t buildValidPairsMatrix(const matrixOps::crsMat_t &A, const Parameters &p)
+  {
+    return matrixOps::graphToMatrix(buildValidPairsGraph(A.graph, p));
+  }
 }
 
 #endif
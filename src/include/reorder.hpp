@@ -0,0 +1,305 @@
+/**
+ * @file    reorder.hpp
+ * @brief   vertex reordering of the adjacency pattern before index construction
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_REORDER_HPP
+#define PAIRG_REORDER_HPP
+
+#include <numeric>
+
+#include "spgemm_utility.hpp"
+#include "parseCmdArgs.hpp"
+#include "utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     mapping from vertex ids of the loaded graph to ids used by
+   *            the adjacency pattern and the index
+   */
+  struct vertexPermutation
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    //new id of each original vertex, empty if vertices are not reordered
+    matrixOps::lno_nnz_view_t toNew;
+
+    bool identity() const { return toNew.extent(0) == 0; }
+
+    lno_t operator()(lno_t v) const { return identity() ? v : toNew(v); }
+  };
+
+  /**
+   * @brief     vertex orderings, computed on the adjacency pattern
+   * @details   each function returns the original vertex id at every new position
+   */
+  struct vertexOrder
+  {
+    typedef matrixOps::lno_t lno_t;
+    typedef matrixOps::size_type size_type;
+
+    /**
+     * @brief               breadth-first order on the undirected graph, components
+     *                      in order of their lowest vertex id
+     */
+    static std::vector<lno_t> bfs(const matrixOps::graph_t &A)
+    {
+      matrixOps::graph_t AT = matrixOps::transposeGraph(A);
+
+      std::vector<lno_t> starts (A.numRows());
+      std::iota(starts.begin(), starts.end(), 0);
+
+      return undirectedBFS(A, AT, starts, false);
+    }
+
+    /**
+     * @brief               reverse Cuthill-McKee order on the undirected graph
+     * @details             each component starts from its vertex of lowest degree,
+     *                      neighbors are visited by increasing degree, and the
+     *                      final order is reversed
+     */
+    static std::vector<lno_t> rcm(const matrixOps::graph_t &A)
+    {
+      matrixOps::graph_t AT = matrixOps::transposeGraph(A);
+
+      std::vector<lno_t> starts (A.numRows());
+      std::iota(starts.begin(), starts.end(), 0);
+      std::stable_sort(starts.begin(), starts.end(), [&](lno_t u, lno_t v) { return degree(A, AT, u) < degree(A, AT, v); });
+
+      std::vector<lno_t> order = undirectedBFS(A, AT, starts, true);
+      std::reverse(order.begin(), order.end());
+      return order;
+    }
+
+    /**
+     * @brief               depth-first topological order
+     * @details             - Kahn's algorithm with a stack, so that a vertex is
+     *                        followed by its successors where possible and chains
+     *                        stay contiguous
+     *                      - on a cyclic graph, whenever no vertex is free, the
+     *                        lowest unplaced id is placed next, i.e. its remaining
+     *                        incoming edges become backward edges
+     */
+    static std::vector<lno_t> topological(const matrixOps::graph_t &A)
+    {
+      lno_t n = A.numRows();
+
+      std::vector<lno_t> indegree (n, 0);
+      for(size_type k = 0; k < A.entries.extent(0); k++)
+        indegree[A.entries(k)]++;
+
+      std::vector<lno_t> order, stack;
+      std::vector<bool> placed (n, false);
+      order.reserve(n);
+
+      for(lno_t v = n - 1; v >= 0; v--)
+        if (indegree[v] == 0)
+          stack.push_back(v);
+
+      lno_t forced = 0, lowest = 0;
+
+      while ((lno_t) order.size() < n)
+      {
+        if (stack.empty())
+        {
+          while (placed[lowest])
+            lowest++;
+          stack.push_back(lowest);
+          forced++;
+        }
+
+        lno_t v = stack.back();
+        stack.pop_back();
+
+        if (placed[v])
+          continue;
+
+        placed[v] = true;
+        order.push_back(v);
+
+        //reversed, so that the first successor is expanded first
+        for(size_type k = A.row_map(v+1); k > A.row_map(v); k--)
+        {
+          lno_t w = A.entries(k - 1);
+          if (!placed[w] && --indegree[w] == 0)
+            stack.push_back(w);
+        }
+      }
+
+      if (forced > 0)
+        std::cout << "INFO, pairg::vertexOrder::topological, graph is cyclic, cycles broken at " << forced << " vertices" << std::endl;
+
+      return order;
+    }
+
+    private:
+
+    static lno_t degree(const matrixOps::graph_t &A, const matrixOps::graph_t &AT, lno_t v)
+    {
+      return (A.row_map(v+1) - A.row_map(v)) + (AT.row_map(v+1) - AT.row_map(v));
+    }
+
+    /**
+     * @param[in]   starts    candidate start vertices, in order of preference
+     * @param[in]   byDegree  visit neighbors of a vertex by increasing degree
+     */
+    static std::vector<lno_t> undirectedBFS(const matrixOps::graph_t &A, const matrixOps::graph_t &AT, const std::vector<lno_t> &starts, bool byDegree)
+    {
+      lno_t n = A.numRows();
+
+      std::vector<lno_t> order;
+      std::vector<bool> visited (n, false);
+      order.reserve(n);
+
+      for(auto s : starts)
+      {
+        if (visited[s])
+          continue;
+
+        visited[s] = true;
+        order.push_back(s);
+
+        //order doubles as the queue
+        for(std::size_t head = order.size() - 1; head < order.size(); head++)
+        {
+          lno_t v = order[head];
+          std::size_t first = order.size();
+
+          for(const matrixOps::graph_t *G : {&A, &AT})
+            for(size_type k = G->row_map(v); k < G->row_map(v+1); k++)
+            {
+              lno_t w = G->entries(k);
+              if (!visited[w])
+              {
+                visited[w] = true;
+                order.push_back(w);
+              }
+            }
+
+          if (byDegree)
+            std::stable_sort(order.begin() + first, order.end(), [&](lno_t u, lno_t w) { return degree(A, AT, u) < degree(A, AT, w); });
+        }
+      }
+
+      return order;
+    }
+  };
+
+  /**
+   * @brief               relabel vertices of a sparsity pattern
+   * @param[in] toNew     new id of each vertex
+   * @return              pattern with entry (toNew[i], toNew[j]) for every entry (i, j),
+   *                      rows sorted
+   */
+  matrixOps::graph_t permuteGraph(const matrixOps::graph_t &A, const matrixOps::lno_nnz_view_t &toNew)
+  {
+    typedef matrixOps::lno_t lno_t;
+    typedef matrixOps::size_type size_type;
+
+    lno_t n = A.numRows();
+
+    std::vector<lno_t> toOld (n);
+    for(lno_t v = 0; v < n; v++)
+      toOld[toNew(v)] = v;
+
+    matrixOps::lno_view_t row_map ("row_map", n + 1);
+    Kokkos::parallel_for("pairg::permuteGraph::count", matrixOps::range_type(0, n), [&](const lno_t r)
+    {
+      row_map(r + 1) = A.row_map(toOld[r] + 1) - A.row_map(toOld[r]);
+    });
+
+    size_type nnz = matrixOps::prefixSum(row_map);
+    matrixOps::lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+
+    Kokkos::parallel_for("pairg::permuteGraph::fill", matrixOps::range_type(0, n), [&](const lno_t r)
+    {
+      lno_t v = toOld[r];
+      size_type out = row_map(r);
+
+      for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+        entries(out++) = toNew(A.entries(k));
+
+      std::sort(entries.data() + row_map(r), entries.data() + row_map(r+1));
+    });
+
+    return matrixOps::graph_t(entries, row_map);
+  }
+
+  /**
+   * @brief               mean distance of entries from the diagonal, a proxy for
+   *                      the column spread of rows in the SpGEMM accumulators
+   */
+  double meanBandwidth(const matrixOps::graph_t &A)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    double sum = 0;
+    Kokkos::parallel_reduce("pairg::meanBandwidth", matrixOps::range_type(0, A.numRows()), [&](const lno_t i, double &update)
+    {
+      for(auto k = A.row_map(i); k < A.row_map(i+1); k++)
+        update += std::abs(A.entries(k) - i);
+    }, sum);
+
+    return A.entries.extent(0) > 0 ? sum / A.entries.extent(0) : 0.0;
+  }
+
+  /**
+   * @brief               reorder vertices of the adjacency pattern as selected by user
+   * @param[in,out] A     adjacency pattern, replaced by the reordered pattern
+   * @param[in] p         input parameters (vertex order)
+   * @return              permutation applied, identity if no reordering was asked for;
+   *                      queries in ids of the loaded graph must be translated with it
+   * @details             ids of an acyclic graph are kept topologically sorted, the
+   *                      topological sweep and the order shortcut of queries rely on
+   *                      it; an rcm or bfs order that breaks this falls back to the
+   *                      topological order, with a warning
+   */
+  vertexPermutation reorderVertices(matrixOps::graph_t &A, const Parameters &p)
+  {
+    typedef matrixOps::lno_t lno_t;
+
+    vertexPermutation perm;
+
+    if (p.vorder.compare("none") == 0)
+      return perm;
+
+    pairg::timer T1;
+    std::vector<lno_t> order;
+
+    if (p.vorder.compare("rcm") == 0)
+      order = vertexOrder::rcm(A);
+    else if (p.vorder.compare("bfs") == 0)
+      order = vertexOrder::bfs(A);
+    else
+      order = vertexOrder::topological(A);
+
+    perm.toNew = matrixOps::lno_nnz_view_t (Kokkos::ViewAllocateWithoutInitializing("toNew"), A.numRows());
+    for(lno_t r = 0; r < A.numRows(); r++)
+      perm.toNew(order[r]) = r;
+
+    double before = meanBandwidth(A);
+    bool acyclic = matrixOps::isUpperTriangular(A);
+    matrixOps::graph_t A_new = permuteGraph(A, perm.toNew);
+
+    if (acyclic && !matrixOps::isUpperTriangular(A_new))
+    {
+      std::cout << "WARNING, pairg::reorderVertices, " << p.vorder << " order breaks topological order of acyclic graph, using topo order instead" << std::endl;
+
+      order = vertexOrder::topological(A);
+      for(lno_t r = 0; r < A.numRows(); r++)
+        perm.toNew(order[r]) = r;
+
+      A_new = permuteGraph(A, perm.toNew);
+    }
+
+    A = A_new;
+
+    std::cout << "INFO, pairg::reorderVertices, " << p.vorder << " order, mean bandwidth " << before << " -> " << meanBandwidth(A) << ", time (ms): " << T1.elapsed() << "\n";
+
+    return perm;
+  }
+}
+
+#endif
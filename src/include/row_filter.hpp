@@ -0,0 +1,119 @@
+/**
+ * @file    row_filter.hpp
+ * @brief   per-row column bounds for fast rejection of negative queries
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_ROW_FILTER_HPP
+#define PAIRG_ROW_FILTER_HPP
+
+#include "spgemm_utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     summary of the columns present in each row of a valid-pairs
+   *            pattern, used to reject queries before searching the index
+   * @details   - per row: smallest and largest column, and a 64-bit map of
+   *              non-empty column blocks; block width is the smallest power
+   *              of two that splits [lo, hi] into at most 64 blocks
+   *            - all three fields share 16 bytes, a query touches a single
+   *              cache line
+   *            - topological vertex order keeps columns of a row close to each
+   *              other, so bounds are tight and most negatives are rejected
+   *            - never rejects a pair that is present, combine with any index:
+   *              mayContain(i, j) && index.queryValue(i, j)
+   */
+  class rowFilter
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+      typedef matrixOps::range_type range_type;
+
+      struct rowBounds
+      {
+        lno_t lo, hi;           //column range, lo > hi for empty rows
+        uint64_t blocks;        //bit b set iff a column lies in block b
+      };
+
+      typedef Kokkos::View<rowBounds*, matrixOps::Device> bounds_view_t;
+
+      //count of rows
+      lno_t numRows;
+
+      bounds_view_t bounds;
+
+      rowFilter() : numRows(0) {}
+
+      /**
+       * @brief                 build filter from a sparsity pattern
+       * @param[in]   G         valid-pairs pattern, entries within each row
+       *                        must be sorted (see matrixOps::indexForQuery)
+       */
+      void build(const matrixOps::graph_t &G)
+      {
+        numRows = G.numRows();
+        bounds = bounds_view_t (Kokkos::ViewAllocateWithoutInitializing("bounds"), numRows);
+
+        Kokkos::parallel_for("pairg::rowFilter::build", range_type(0, numRows), [&](const lno_t i)
+        {
+          rowBounds &b = bounds(i);
+          size_type begin = G.row_map(i), end = G.row_map(i+1);
+
+          b.blocks = 0;
+
+          if (begin == end)
+          {
+            b.lo = 1;
+            b.hi = 0;
+            return;
+          }
+
+          b.lo = G.entries(begin);
+          b.hi = G.entries(end - 1);
+
+          int shift = blockShift(b);
+          for(size_type k = begin; k < end; k++)
+            b.blocks |= 1ULL << ((G.entries(k) - b.lo) >> shift);
+        });
+      }
+
+      /**
+       * @brief                 false if column j is certainly absent from row i
+       * @note                  row and column indices should be 0-based and in range
+       */
+      bool mayContain(lno_t i, lno_t j) const
+      {
+        const rowBounds &b = bounds(i);
+
+        if (j < b.lo || j > b.hi)
+          return false;
+
+        return (b.blocks >> ((j - b.lo) >> blockShift(b))) & 1ULL;
+      }
+
+      /**
+       * @brief                 total size (in bytes) of filter
+       */
+      std::size_t memoryBytes() const
+      {
+        return bounds.extent(0) * sizeof(rowBounds);
+      }
+
+    private:
+
+      /**
+       * @brief                 log2 of block width for a non-empty row
+       */
+      static int blockShift(const rowBounds &b)
+      {
+        uint32_t span = b.hi - b.lo;
+        int bits = span == 0 ? 0 : 32 - __builtin_clz(span);
+        return bits > 6 ? bits - 6 : 0;
+      }
+  };
+}
+
+#endif
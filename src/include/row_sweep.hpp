@@ -0,0 +1,97 @@
+/**
+ * @file    row_sweep.hpp
+ * @brief   single-row evaluation of the valid-pairs pattern
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#ifndef PAIRG_ROW_SWEEP_HPP
+#define PAIRG_ROW_SWEEP_HPP
+
+#include "spgemm_utility.hpp"
+
+namespace pairg
+{
+  /**
+   * @brief     computes one row of A^d_low * (A+I)^(d_up-d_low) by a bounded
+   *            frontier expansion from the row's vertex
+   * @details   - level t holds the distinct vertices reachable by a walk of
+   *              exactly t edges, the row is the union of levels d_low..d_up
+   *            - cost is proportional to the edges leaving the frontiers, no
+   *              matrix power is formed
+   *            - holds two bitmaps over all vertices, use one object per thread
+   */
+  class rowSweep
+  {
+    public:
+
+      typedef matrixOps::lno_t lno_t;
+      typedef matrixOps::size_type size_type;
+
+      rowSweep(lno_t n) : seen((n + 63) / 64, 0), found((n + 63) / 64, 0) {}
+
+      /**
+       * @brief                 compute row i
+       * @param[in]   A         sparsity pattern of graph adjacency matrix
+       * @param[out]  cols      sorted columns of row i
+       */
+      void compute(const matrixOps::graph_t &A, lno_t i, int d_low, int d_up, std::vector<lno_t> &cols)
+      {
+        cols.clear();
+        current.assign(1, i);
+
+        for(int level = 0; level <= d_up && !current.empty(); level++)
+        {
+          if (level >= d_low)
+            for(auto v : current)
+              if (!test(found, v))
+              {
+                set(found, v);
+                cols.push_back(v);
+              }
+
+          if (level == d_up)
+            break;
+
+          next.clear();
+          for(auto v : current)
+            for(size_type k = A.row_map(v); k < A.row_map(v+1); k++)
+            {
+              lno_t w = A.entries(k);
+              if (!test(seen, w))
+              {
+                set(seen, w);
+                next.push_back(w);
+              }
+            }
+
+          //only words touched by this level are cleared
+          for(auto w : next)
+            seen[w >> 6] = 0;
+
+          std::swap(current, next);
+        }
+
+        for(auto v : cols)
+          found[v >> 6] = 0;
+
+        std::sort(cols.begin(), cols.end());
+      }
+
+    private:
+
+      std::vector<uint64_t> seen, found;
+      std::vector<lno_t> current, next;
+
+      static bool test(const std::vector<uint64_t> &bitmap, lno_t v)
+      {
+        return (bitmap[v >> 6] >> (v & 63)) & 1ULL;
+      }
+
+      static void set(std::vector<uint64_t> &bitmap, lno_t v)
+      {
+        bitmap[v >> 6] |= 1ULL << (v & 63);
+      }
+  };
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include <type_traits>
 #include <cassert>
 #include <typeinfo> 
+#include <vector>
 
 //Own includes
 #include "utility.hpp" 
@@ -47,6 +48,9 @@ namespace pairg
       typedef typename graph_t::entries_type::non_const_type lno_nnz_view_t;
       typedef typename lno_view_t::value_type size_type;
 
+      //query results, one byte per query
+      typedef Kokkos::View<uint8_t*, Device> result_view_t;
+
       //Kokkos's KernelHandle
       typedef KokkosKernels::Experimental::KokkosKernelsHandle
         <size_type, lno_t, scalar_t,
@@ -217,6 +221,376 @@ namespace pairg
         return C; 
       }
 
+      /**
+       * @brief     boolean addition of two sparsity patterns
+       * @details   structure-only counterpart of addMatrices, no values array
+       *            is allocated; entries within each row of the result are sorted
+       * @return    pattern of C = A '+' B
+       */
+      static graph_t addGraphs(const graph_t &A, const graph_t &B)
+      {
+        assert(A.numRows() == B.numRows());
+
+        auto collectRow = [&](const lno_t i, std::vector<uint64_t> &bitmap, std::vector<lno_t> &cols)
+        {
+          for(size_type a = A.row_map(i); a < A.row_map(i+1); a++)
+            markColumn(A.entries(a), bitmap, cols);
+
+          for(size_type b = B.row_map(i); b < B.row_map(i+1); b++)
+            markColumn(B.entries(b), bitmap, cols);
+        };
+
+        return assembleGraph(A.numRows(), A.numRows(), collectRow, "pairg::matrixOps::addGraphs");
+      }
+
+      /**
+       * @brief     boolean multiplication of two sparsity patterns
+       * @details   - structure-only counterpart of multiplyMatrices, no values
+       *              array is allocated, filled or reset
+       *            - row-wise (Gustavson) product, each thread accumulates
+       *              columns of a row in a dense bitmap over the columns of B
+       *            - entries within each row of the result are sorted
+       *            - B is assumed square, as are all matrices in PairG
+       * @return    pattern of C = A '*' B
+       */
+      static graph_t multiplyGraphs(const graph_t &A, const graph_t &B)
+      {
+        return assembleGraph(A.numRows(), B.numRows(), productRow(A, B), "pairg::matrixOps::multiplyGraphs");
+      }
+
+      /**
+       * @brief     check whether squaring a pattern with full diagonal left it unchanged
+       * @param[in] B       pattern with full diagonal (see hasFullDiagonal)
+       * @param[in] B2      pattern of B * B
+       * @details   B2 contains B, so equal row sizes imply equal patterns; B is then
+       *            a fixed point, B^k = B for every k >= 1
+       */
+      static bool saturated(const graph_t &B, const graph_t &B2)
+      {
+        if (B.entries.extent(0) != B2.entries.extent(0))
+          return false;
+
+        size_type differ = 0;
+        Kokkos::parallel_reduce("pairg::matrixOps::saturated", range_type(0, B.numRows()), [&](const lno_t i, size_type &update)
+        {
+          if (B.row_map(i+1) != B2.row_map(i+1))
+            update++;
+        }, differ);
+
+        return differ == 0;
+      }
+
+      /**
+       * @brief     visit rows of the boolean product A * B without materializing it
+       * @param[in] visit   functor (i, cols) called once per row of the product, 
+       *                    with sorted columns; called in parallel across rows
+       * @details   lets callers emit their own row encoding directly from the 
+       *            product, e.g., in a count pass followed by a write pass
+       */
+      template <typename VisitFn>
+        static void forEachProductRow(const graph_t &A, const graph_t &B, const VisitFn &visit, const std::string &label)
+        {
+          forEachProductRow(A, B, 0, A.numRows(), visit, label);
+        }
+
+      /**
+       * @brief     visit rows [row_begin, row_end) of the boolean product A * B 
+       *            without materializing it, see forEachProductRow() above
+       */
+      template <typename VisitFn>
+        static void forEachProductRow(const graph_t &A, const graph_t &B, lno_t row_begin, lno_t row_end, const VisitFn &visit, const std::string &label)
+        {
+          //single factor, rows of A are visited as they are
+          if (missingFactor(B))
+          {
+            Kokkos::parallel_for(label, range_type(row_begin, row_end), [&](const lno_t i)
+            {
+              const std::vector<lno_t> cols (A.entries.data() + A.row_map(i), A.entries.data() + A.row_map(i+1));
+              visit(i, cols);
+            });
+            return;
+          }
+
+          visitRows(row_begin, row_end, B.numRows(), productRow(A, B), [&](const lno_t i, std::vector<lno_t> &cols)
+          {
+            std::sort(cols.begin(), cols.end());
+            visit(i, (const std::vector<lno_t> &) cols);
+          }, label);
+        }
+
+      /**
+       * @brief   a factor base^exponent in a product of matrix powers
+       */
+      struct powerTerm
+      {
+        graph_t base;
+        int exponent;
+
+        powerTerm(const graph_t &base_, int exponent_) : base(base_), exponent(exponent_) {}
+      };
+
+      /**
+       * @brief               reduce a product of powers of commuting square matrices,
+       *                      e.g., A^l * (A+I)^(u-l), to two factors C and D 
+       * @param[in] terms     factors of the product, taken by value so that each base
+       *                      can be released as soon as its squarings are done
+       * @param[in] nrows     count of rows
+       * @param[out] C, D     product equals C * D, the final multiplication is left 
+       *                      to the caller (e.g., to emit a custom row encoding);
+       *                      D is left empty if the product is a single factor,
+       *                      see multiplyFactors()
+       * @return              count of SpGEMM calls, excluding the final multiplication
+       * @details             - all terms share one binary schedule and one accumulator,
+       *                        initialized with the first power needed instead of the
+       *                        identity matrix
+       *                      - a base is squared only while higher bits of its exponent 
+       *                        remain
+       *                      - a power is multiplied into the accumulator and dropped as 
+       *                        soon as the next power is available
+       *                      - identity is returned only if the product has no factor
+       *                        at all (d_low = d_up = 0)
+       *                      - a base with full diagonal (e.g., A+I) stops being squared
+       *                        once a squaring leaves its pattern unchanged, see
+       *                        saturated()
+       */
+      static int powerFactors(std::vector<powerTerm> terms, lno_t nrows, graph_t &C, graph_t &D)
+      {
+        factorAccumulator acc;
+
+        for(auto &term : terms)
+        {
+          graph_t sq = term.base;
+          term.base = graph_t();
+
+          bool reflexive = term.exponent > 1 && hasFullDiagonal(sq);
+
+          for(int n = term.exponent, b = 0; n > 0; n = n >> 1, b++)
+          {
+            if (n & 1)
+              acc.take(sq);
+
+            //no squaring after the highest bit
+            if (n > 1)
+            {
+              graph_t next = multiplyGraphs(sq, sq);
+              acc.spgemm_calls++;
+
+              if (reflexive && saturated(sq, next))
+              {
+                //every remaining power equals sq, which absorbs the powers taken so far
+                if (!(n & 1))
+                  acc.take(sq);
+
+                std::cout << "INFO, pairg::matrixOps::powerFactors, pattern saturated at power 2^" << b << ", skipping squarings up to exponent " << term.exponent << std::endl;
+                break;
+              }
+
+              sq = next;
+            }
+          }
+        }
+
+        acc.finish(nrows, C, D);
+
+        std::cout << "INFO, pairg::matrixOps::powerFactors, SpGEMM calls = " << acc.spgemm_calls << " (excluding final multiplication)" << std::endl;
+
+        return acc.spgemm_calls;
+      }
+
+      /**
+       * @brief               check whether powerFactors() returned a single factor
+       *                      (second factor left empty)
+       */
+      static bool missingFactor(const graph_t &D)
+      {
+        return D.row_map.extent(0) == 0;
+      }
+
+      /**
+       * @brief               final multiplication C * D of the factors returned by
+       *                      powerFactors(), skipped if D is missing
+       */
+      static graph_t multiplyFactors(const graph_t &C, const graph_t &D)
+      {
+        if (missingFactor(D))
+          return C;
+
+        return multiplyGraphs(C, D);
+      }
+
+      /**
+       * @brief   repeated squarings base^(2^b) of a square matrix, computed on
+       *          demand and kept for reuse across several products
+       * @details squares no longer needed by the remaining products are dropped
+       *          with release(), the last square is always kept for further
+       *          squarings
+       */
+      class squareCache
+      {
+        public:
+
+          //count of squarings done so far
+          int spgemm_calls;
+
+          squareCache(const graph_t &base) : spgemm_calls(0), squares(1, base), reflexive(hasFullDiagonal(base)), fixedPoint(-1) {}
+
+          /**
+           * @brief           compute squarings up to base^(2^b), or up to the
+           *                  fixed point if the pattern saturates before
+           */
+          void extend(int b)
+          {
+            while ((int) squares.size() <= b && fixedPoint < 0)
+            {
+              graph_t next = multiplyGraphs(squares.back(), squares.back());
+              spgemm_calls++;
+
+              if (reflexive && matrixOps::saturated(squares.back(), next))
+              {
+                fixedPoint = squares.size() - 1;
+                std::cout << "INFO, pairg::matrixOps::squareCache, pattern saturated at power 2^" << fixedPoint << std::endl;
+              }
+              else
+                squares.push_back(next);
+            }
+          }
+
+          /**
+           * @brief           base^(2^b), must not have been released
+           */
+          const graph_t& square(int b)
+          {
+            extend(b);
+
+            assert(squares[std::min(b, (int) squares.size() - 1)].row_map.extent(0) > 0);
+            return squares[std::min(b, (int) squares.size() - 1)];
+          }
+
+          /**
+           * @brief           drop squares that no remaining product needs
+           * @param[in] bits  bitwise or of the exponents of the remaining products,
+           *                  square b is kept iff bit b is set (or b is the last square)
+           */
+          void release(int bits)
+          {
+            for(int b = 0; b + 1 < (int) squares.size(); b++)
+              if (!((bits >> b) & 1))
+                squares[b] = graph_t();
+          }
+
+          /**
+           * @brief           count of squares held in memory
+           */
+          int heldSquares() const
+          {
+            int held = 0;
+            for(auto &sq : squares)
+              held += sq.row_map.extent(0) > 0;
+            return held;
+          }
+
+          /**
+           * @brief           check whether base^(2^b) is known to equal all higher powers
+           */
+          bool saturated(int b) const
+          {
+            return fixedPoint >= 0 && b >= fixedPoint;
+          }
+
+        private:
+
+          std::vector<graph_t> squares;
+
+          //base has full diagonal
+          bool reflexive;
+
+          //index of the square equal to all higher powers, -1 if not reached yet
+          int fixedPoint;
+      };
+
+      /**
+       * @brief               reduce a product of powers to two factors C and D, 
+       *                      like powerFactors(), taking the squarings of each base 
+       *                      from a cache shared with other products
+       * @param[in] terms     (cache of base, exponent) for each factor
+       * @return              count of SpGEMM calls for this product, excluding 
+       *                      squarings and the final multiplication
+       */
+      static int powerFactors(const std::vector< std::pair<squareCache*, int> > &terms, lno_t nrows, graph_t &C, graph_t &D)
+      {
+        factorAccumulator acc;
+
+        for(auto &term : terms)
+          for(int b = 0; (term.second >> b) > 0; b++)
+          {
+            //square needed next anyway, computing it first tells whether this one is saturated
+            if ((term.second >> b) > 1)
+              term.first->extend(b + 1);
+
+            //remaining product equals this square, see powerFactors() above
+            if (term.first->saturated(b))
+            {
+              acc.take(term.first->square(b));
+              break;
+            }
+
+            if ((term.second >> b) & 1)
+              acc.take(term.first->square(b));
+          }
+
+        acc.finish(nrows, C, D);
+
+        return acc.spgemm_calls;
+      }
+
+      /**
+       * @brief   raise the sparsity pattern of a square matrix to a power
+       *          (boolean semiring, structure only)
+       * @return  pattern of A^n, entries within each row are sorted
+       */
+      static graph_t power(const graph_t &A, int n)
+      {
+        std::vector<powerTerm> terms (1, powerTerm(A, n));
+
+        graph_t C, D;
+        powerFactors(std::move(terms), A.numRows(), C, D);
+
+        return multiplyFactors(C, D);
+      }
+
+      /**
+       * @brief                       query value at given coordinates in a given sparsity pattern
+       * @note                        row and column indices should be 0-based
+       *                              the entries in each row are assumed sorted
+       */
+      static bool queryValue(const graph_t &A, lno_t i, lno_t j)
+      {
+        if (i >= A.numRows () || j >= A.numRows ()) {
+          std::cout << "WARNING, pairg::matrixOps::queryValue, query index out of range" << std::endl;
+          return false;
+        }
+
+        size_type begin = A.row_map(i);
+        size_type end = A.row_map(i + 1);
+
+        return std::binary_search(A.entries.data() + begin, A.entries.data() + end, j);
+      }
+
+      /**
+       * @brief                       wrap a sparsity pattern into a boolean matrix
+       * @details                     allocates a values array with all nnz values set as 1,
+       *                              only needed by callers that still expect crsMat_t
+       */
+      static crsMat_t graphToMatrix(const graph_t &G, const std::string &label = "C")
+      {
+        size_type nnz = G.entries.extent(0);
+
+        scalar_view_t values (Kokkos::ViewAllocateWithoutInitializing("values"), nnz);
+        Kokkos::deep_copy(values, (scalar_t) 1);
+
+        return crsMat_t(label, G.numRows(), values, G);
+      }
+
       /**
        * @brief                       query value at given coordinates in a given matrix
        * @note                        row and column indices should be 0-based
@@ -240,13 +614,94 @@ namespace pairg
         //return (it != (A.graph.entries.data() + end));
       }
 
+      /**
+       * @brief                       answer a batch of queries in parallel
+       * @param[in] query             functor (i, j) -> bool, e.g., queryValue() of an index
+       * @param[in] numRows           count of rows (= count of columns) of the index
+       * @param[in] src, dst          coordinates of the queries
+       * @param[out] results          results(k) = 1 iff query k is present, caller allocated
+       * @param[in] sortByRow         process queries grouped by row block, results are
+       *                              scattered back in input order
+       * @return                      count of queries out of range, answered with 0
+       * @details                     - coordinates are range checked once per batch,
+       *                                query is only called for valid pairs
+       *                              - grouping is a parallel counting sort of the queries
+       *                                on row blocks, with about one block per query
+       */
+      template <typename QueryFn>
+        static size_type queryBatch(const QueryFn &query, lno_t numRows, const lno_nnz_view_t &src, const lno_nnz_view_t &dst, const result_view_t &results, bool sortByRow = false)
+        {
+          lno_t count = src.extent(0);
+          assert(dst.extent(0) == src.extent(0) && results.extent(0) == src.extent(0));
+
+          auto inRange = [&](const lno_t k)
+          {
+            return src(k) >= 0 && src(k) < numRows && dst(k) >= 0 && dst(k) < numRows;
+          };
+
+          size_type invalid = 0;
+          Kokkos::parallel_reduce("pairg::matrixOps::queryBatch::check", range_type(0, count), [&](const lno_t k, size_type &update)
+          {
+            if (!inRange(k))
+            {
+              results(k) = 0;
+              update++;
+            }
+          }, invalid);
+
+          if (invalid > 0)
+            std::cout << "WARNING, pairg::matrixOps::queryBatch, " << invalid << " queries out of range" << std::endl;
+
+          if (!sortByRow)
+          {
+            Kokkos::parallel_for("pairg::matrixOps::queryBatch", range_type(0, count), [&](const lno_t k)
+            {
+              if (inRange(k))
+                results(k) = query(src(k), dst(k));
+            });
+
+            return invalid;
+          }
+
+          //row blocks of 2^shift rows, at most about one block per query
+          int shift = 0;
+          while ((numRows >> shift) > count)
+            shift++;
+          lno_t blocks = (numRows >> shift) + 1;
+
+          lno_view_t offsets ("offsets", blocks + 1);
+          Kokkos::parallel_for("pairg::matrixOps::queryBatch::count", range_type(0, count), [&](const lno_t k)
+          {
+            if (inRange(k))
+              Kokkos::atomic_increment(&offsets((src(k) >> shift) + 1));
+          });
+          size_type valid = prefixSum(offsets);
+
+          lno_view_t cursor (Kokkos::ViewAllocateWithoutInitializing("cursor"), blocks + 1);
+          Kokkos::deep_copy(cursor, offsets);
+
+          lno_nnz_view_t order (Kokkos::ViewAllocateWithoutInitializing("order"), valid);
+          Kokkos::parallel_for("pairg::matrixOps::queryBatch::group", range_type(0, count), [&](const lno_t k)
+          {
+            if (inRange(k))
+              order(Kokkos::atomic_fetch_add(&cursor(src(k) >> shift), (size_type) 1)) = k;
+          });
+
+          Kokkos::parallel_for("pairg::matrixOps::queryBatch", range_type(0, valid), [&](const lno_t pos)
+          {
+            lno_t k = order(pos);
+            results(k) = query(src(k), dst(k));
+          });
+
+          return invalid;
+        }
+
       /**
        * @brief                       sort indices within each row, required for fast querying
        */
       static void indexForQuery(crsMat_t &A)
       {
         lno_t num_rows = A.numRows();
-        size_type nnz = A.graph.entries.extent(0);
 
         //Functor to sort entries within each row
         auto sortEntries = [&](const lno_t i)
@@ -282,6 +737,26 @@ namespace pairg
         std::cout << "\n";
       }
 
+      /**
+       * @brief                       print sparsity pattern to stdout
+       * @param[in]  verbose          1 - just print pattern properties
+       *                              2 - print pattern properties and limited set of values
+       *                              3 - print pattern properties and all values
+       */
+      static void printMatrix(const graph_t &A, int verbose)
+      {
+        std::cout << "INFO, pairg::matrixOps::printMatrix, row map size:" << A.row_map.extent(0) << "\n";
+        std::cout << "INFO, pairg::matrixOps::printMatrix, entries (nnz):" << A.entries.extent(0) << "\n";
+
+        if(verbose > 1) 
+        {
+          KokkosKernels::Impl::print_1Dview(A.row_map, verbose > 2);
+          KokkosKernels::Impl::print_1Dview(A.entries, verbose > 2);
+        }
+
+        std::cout << "\n";
+      }
+
       /**
        * @brief   a small utility function to print size (in bytes) of commonly 
        *          used types during matrix operations
@@ -333,6 +808,112 @@ namespace pairg
         return crsMat_t("identity matrix", nrows, nrows, nnz, values, rowmap, entries);
       }
 
+      /**
+       * @brief                       create sparsity pattern of a square identity matrix
+       * @param[in] nrows             count of rows
+       * @return                      the generated pattern
+       */
+      static graph_t createIdentityGraph(lno_t nrows)
+      {
+        lno_view_t rowmap("rowmap", nrows + 1);
+        lno_nnz_view_t entries("entries", nrows);
+
+        Kokkos::parallel_for("pairg::matrixOps::createIdentityGraph", range_type(0, nrows), [&](const lno_t i)
+        {
+          rowmap(i + 1) = i + 1;
+          entries(i) = i;
+        });
+
+        return graph_t(entries, rowmap);
+      }
+
+      /**
+       * @brief                       transpose a square sparsity pattern
+       * @return                      pattern of A^T, entries within each row are not sorted
+       */
+      static graph_t transposeGraph(const graph_t &A)
+      {
+        lno_t nrows = A.numRows();
+        lno_view_t rowmap("rowmap", nrows + 1);
+
+        Kokkos::parallel_for("pairg::matrixOps::transposeGraph::count", range_type(0, nrows), [&](const lno_t i)
+        {
+          for(size_type k = A.row_map(i); k < A.row_map(i+1); k++)
+            Kokkos::atomic_increment(&rowmap(A.entries(k) + 1));
+        });
+
+        size_type nnz = prefixSum(rowmap);
+
+        lno_view_t cursor (Kokkos::ViewAllocateWithoutInitializing("cursor"), nrows + 1);
+        Kokkos::deep_copy(cursor, rowmap);
+
+        lno_nnz_view_t entries (Kokkos::ViewAllocateWithoutInitializing("entries"), nnz);
+        Kokkos::parallel_for("pairg::matrixOps::transposeGraph::fill", range_type(0, nrows), [&](const lno_t i)
+        {
+          for(size_type k = A.row_map(i); k < A.row_map(i+1); k++)
+            entries(Kokkos::atomic_fetch_add(&cursor(A.entries(k)), (size_type) 1)) = i;
+        });
+
+        return graph_t(entries, rowmap);
+      }
+
+      /**
+       * @brief                       check whether every entry lies strictly above the diagonal
+       * @details                     true iff vertex ids are a topological order of an
+       *                              acyclic graph
+       */
+      static bool isUpperTriangular(const graph_t &A)
+      {
+        size_type below = 0;
+
+        Kokkos::parallel_reduce("pairg::matrixOps::isUpperTriangular", range_type(0, A.numRows()), [&](const lno_t i, size_type &update)
+        {
+          for(size_type k = A.row_map(i); k < A.row_map(i+1); k++)
+            if (A.entries(k) <= i)
+              update++;
+        }, below);
+
+        return below == 0;
+      }
+
+      /**
+       * @brief                       check whether every diagonal entry is present, e.g., A+I
+       * @details                     powers of such a pattern only grow, B^k is contained
+       *                              in B^(k+1); rows are assumed sorted
+       */
+      static bool hasFullDiagonal(const graph_t &A)
+      {
+        size_type missing = 0;
+
+        Kokkos::parallel_reduce("pairg::matrixOps::hasFullDiagonal", range_type(0, A.numRows()), [&](const lno_t i, size_type &update)
+        {
+          if (!std::binary_search(A.entries.data() + A.row_map(i), A.entries.data() + A.row_map(i+1), i))
+            update++;
+        }, missing);
+
+        return missing == 0;
+      }
+
+      /**
+       * @brief                       convert per-row counts into row offsets (in place)
+       * @param[in,out] offsets       count of row i is expected at offsets(i+1), 
+       *                              offsets(0) should be 0
+       * @return                      total count
+       */
+      static size_type prefixSum(lno_view_t &offsets)
+      {
+        lno_t n = offsets.extent(0) - 1;
+
+        Kokkos::parallel_scan("pairg::matrixOps::prefixSum", range_type(0, n), [&](const lno_t i, size_type &update, const bool final)
+        {
+          update += offsets(i + 1);
+          if (final)
+            offsets(i + 1) = update;
+        });
+
+        return offsets(n);
+      }
+
       /**
        * @brief                       create a random square matrix for testing, using kokkos-kernels
        * @param[in] nrows             count of rows
@@ -395,6 +976,144 @@ namespace pairg
 
         return crsMat_t("test matrix", nrows, nrows, nnz, values, rowmap, entries);
       }
+
+    private:
+
+      /**
+       * @brief   product of powers accumulated one factor at a time, the last 
+       *          multiplication is kept pending (see powerFactors)
+       */
+      struct factorAccumulator
+      {
+        std::vector<graph_t> ready;   //at most two: accumulator and pending power
+        int spgemm_calls;
+
+        factorAccumulator() : spgemm_calls(0) {}
+
+        void take(const graph_t &F)
+        {
+          if (ready.size() == 2)
+          {
+            ready[0] = multiplyGraphs(ready[0], ready[1]);
+            ready.pop_back();
+            spgemm_calls++;
+          }
+          ready.push_back(F);
+        }
+
+        //D is left empty for a single factor, identity is returned for none
+        void finish(lno_t nrows, graph_t &C, graph_t &D)
+        {
+          C = ready.empty() ? createIdentityGraph(nrows) : ready[0];
+          D = ready.size() == 2 ? ready[1] : graph_t();
+        }
+      };
+
+      /**
+       * @brief                       record column j in a row accumulator, unless already present
+       * @param[in,out] bitmap        dense bitmap over all columns, one bit per column
+       * @param[in,out] cols          distinct columns recorded so far
+       */
+      static inline void markColumn(lno_t j, std::vector<uint64_t> &bitmap, std::vector<lno_t> &cols)
+      {
+        uint64_t mask = 1ULL << (j & 63);
+
+        if (!(bitmap[j >> 6] & mask))
+        {
+          bitmap[j >> 6] |= mask;
+          cols.push_back(j);
+        }
+      }
+
+      /**
+       * @brief                       row collector for the boolean product A * B,
+       *                              see visitRows()
+       */
+      struct productRow
+      {
+        const graph_t &A;
+        const graph_t &B;
+
+        productRow(const graph_t &A_, const graph_t &B_) : A(A_), B(B_) {}
+
+        void operator() (const lno_t i, std::vector<uint64_t> &bitmap, std::vector<lno_t> &cols) const
+        {
+          for(size_type a = A.row_map(i); a < A.row_map(i+1); a++)
+          {
+            lno_t k = A.entries(a);
+
+            for(size_type b = B.row_map(k); b < B.row_map(k+1); b++)
+              markColumn(B.entries(b), bitmap, cols);
+          }
+        }
+      };
+
+      /**
+       * @brief                       run collectRow on rows [row_begin, row_end) (in parallel) 
+       *                              and hand the collected columns to a visitor
+       * @param[in] collectRow        functor (i, bitmap, cols) that marks all columns of row i
+       *                              using markColumn()
+       * @param[in] visit             functor (i, cols), cols are distinct but not sorted 
+       * @details                     each thread owns one bitmap (num_cols bits), only the 
+       *                              words touched by a row are cleared afterwards
+       */
+      template <typename RowFn, typename VisitFn>
+        static void visitRows(lno_t row_begin, lno_t row_end, lno_t num_cols, const RowFn &collectRow, const VisitFn &visit, const std::string &label)
+        {
+          Kokkos::Experimental::UniqueToken<Device::execution_space> token;
+
+          std::vector< std::vector<uint64_t> > bitmaps (token.size());
+          std::vector< std::vector<lno_t> > colBuffers (token.size());
+
+          Kokkos::parallel_for(label, range_type(row_begin, row_end), [&](const lno_t i)
+          {
+            int t = token.acquire();
+
+            if (bitmaps[t].empty())
+              bitmaps[t].assign(((size_t) num_cols + 63) / 64, 0);
+
+            std::vector<lno_t> &cols = colBuffers[t];
+            cols.clear();
+            collectRow(i, bitmaps[t], cols);
+
+            for(auto j : cols)
+              bitmaps[t][j >> 6] = 0;
+
+            visit(i, cols);
+            token.release(t);
+          });
+        }
+
+      /**
+       * @brief                       build a sparsity pattern row by row in two phases
+       * @param[in] collectRow        see visitRows()
+       * @details                     symbolic phase counts distinct columns per row, a 
+       *                              parallel prefix sum gives the row map, numeric phase 
+       *                              writes sorted columns of each row
+       */
+      template <typename RowFn>
+        static graph_t assembleGraph(lno_t num_rows, lno_t num_cols, const RowFn &collectRow, const std::string &label)
+        {
+          lno_view_t row_map_C (label + "::row_map", num_rows + 1);
+
+          //symbolic phase
+          visitRows(0, num_rows, num_cols, collectRow, [&](const lno_t i, std::vector<lno_t> &cols) 
+          { 
+            row_map_C(i + 1) = cols.size(); 
+          }, label + "::symbolic");
+
+          size_type c_nnz_size = prefixSum(row_map_C);
+          lno_nnz_view_t entries_C (Kokkos::ViewAllocateWithoutInitializing(label + "::entries"), c_nnz_size);
+
+          //numeric phase
+          visitRows(0, num_rows, num_cols, collectRow, [&](const lno_t i, std::vector<lno_t> &cols) 
+          {
+            std::sort(cols.begin(), cols.end());
+            std::copy(cols.begin(), cols.end(), entries_C.data() + row_map_C(i));
+          }, label + "::numeric");
+
+          return graph_t(entries_C, row_map_C);
+        }
   };
 }
 
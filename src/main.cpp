@@ -8,6 +8,17 @@
 #include "parseCmdArgs.hpp"
 #include "reachability.hpp"
 #include "heuristics.hpp"
+#include "hybrid_index.hpp"
+#include "node_index.hpp"
+#include "interval_index.hpp"
+#include "compressed_index.hpp"
+#include "eytzinger_index.hpp"
+#include "row_filter.hpp"
+#include "distance_index.hpp"
+#include "lazy_index.hpp"
+#include "query_planner.hpp"
+#include "reorder.hpp"
+#include "component_index.hpp"
 
 //External includes
 #include "clipp/include/clipp.h"
@@ -24,6 +35,120 @@ std::pair<int,int> getRandomPair(int MAX)
   return std::make_pair(first, second);
 }
 
+/**
+ * @brief     build a set of random distance queries, each vertex id lies in [0, MAX)
+ */
+std::vector< std::pair<int,int> > getRandomPairs(int count, int MAX)
+{
+  std::vector< std::pair<int,int> > random_pairs;
+
+  for(int i = 0; i < count; i++)
+  {
+    auto p = getRandomPair (MAX);
+    random_pairs.push_back(p);
+  }
+
+  return random_pairs;
+}
+
+/**
+ * @brief     answer a batch of random distance queries in parallel, report time taken
+ * @param[in] query   functor (src, dst) -> bool
+ * @param[in] perm    vertex ids of the queries are translated with this permutation
+ *                    before they reach the index
+ */
+template <typename QueryFn>
+void answerQueries(const pairg::Parameters &parameters, int numVertices, const QueryFn &query, const pairg::vertexPermutation &perm = pairg::vertexPermutation())
+{
+  std::vector< std::pair<int,int> > pairs = getRandomPairs (parameters.querycount, numVertices);
+
+  pairg::matrixOps::lno_nnz_view_t src ("src", pairs.size());
+  pairg::matrixOps::lno_nnz_view_t dst ("dst", pairs.size());
+  pairg::matrixOps::result_view_t results ("results", pairs.size());
+
+  for(std::size_t i = 0; i < pairs.size(); i++)
+  {
+    src(i) = perm(pairs[i].first);
+    dst(i) = perm(pairs[i].second);
+  }
+
+  pairg::timer T;
+  pairg::matrixOps::queryBatch(query, numVertices, src, dst, results, parameters.sortqueries);
+  std::cout << "INFO, pairg::main, Time to execute " << pairs.size() << " queries (ms): " << T.elapsed() << "\n";
+}
+
+/**
+ * @brief     answer random distance queries on a complete index through the 
+ *            query planner, print per-strategy counters
+ * @param[in] valid_pairs_mat   pattern the index was built from (see queryPlanner)
+ * @param[in] lookup            functor (src, dst) -> bool answering from the index
+ */
+template <typename LookupFn>
+void answerPlanned(const pairg::Parameters &parameters, const pairg::matrixOps::graph_t &valid_pairs_mat, const LookupFn &lookup, const pairg::vertexPermutation &perm)
+{
+  pairg::queryPlanner planner (parameters, valid_pairs_mat);
+  answerQueries(parameters, planner.numVertices, [&](int i, int j) { return planner.queryValue(i, j, lookup); }, perm);
+  planner.printStats();
+}
+
+/**
+ * @brief     answer random distance queries on a valid-pairs pattern, using
+ *            the index format selected by user, through the query planner
+ */
+void queryPattern(const pairg::Parameters &parameters, const pairg::matrixOps::graph_t &valid_pairs_mat, const pairg::vertexPermutation &perm)
+{
+  //reject most negatives before searching the index
+  pairg::timer T0;
+  pairg::rowFilter filter;
+  filter.build(valid_pairs_mat);
+  std::cout << "INFO, pairg::main, Time to build row filter (ms): " << T0.elapsed() << ", size (bytes): " << filter.memoryBytes() << "\n";
+
+  if (parameters.iformat.compare("hybrid") == 0)
+  {
+    pairg::timer T;
+    pairg::hybridIndex index;
+    index.build(valid_pairs_mat);
+    std::cout << "INFO, pairg::main, Time to build hybrid index (ms): " << T.elapsed() << "\n";
+    index.printStats();
+
+    answerPlanned(parameters, valid_pairs_mat, [&](int i, int j) { return filter.mayContain(i, j) && index.queryValue(i, j); }, perm);
+  }
+  else if (parameters.iformat.compare("interval") == 0)
+  {
+    pairg::timer T;
+    pairg::intervalIndex index;
+    index.build(valid_pairs_mat);
+    std::cout << "INFO, pairg::main, Time to build interval index (ms): " << T.elapsed() << "\n";
+    index.printStats();
+
+    answerPlanned(parameters, valid_pairs_mat, [&](int i, int j) { return filter.mayContain(i, j) && index.queryValue(i, j); }, perm);
+  }
+  else if (parameters.iformat.compare("compressed") == 0)
+  {
+    pairg::timer T;
+    pairg::compressedIndex index;
+    index.build(valid_pairs_mat);
+    std::cout << "INFO, pairg::main, Time to build compressed index (ms): " << T.elapsed() << "\n";
+    index.printStats();
+
+    answerPlanned(parameters, valid_pairs_mat, [&](int i, int j) { return filter.mayContain(i, j) && index.queryValue(i, j); }, perm);
+  }
+  else if (parameters.iformat.compare("eytzinger") == 0)
+  {
+    pairg::timer T;
+    pairg::eytzingerIndex index;
+    index.build(valid_pairs_mat);
+    std::cout << "INFO, pairg::main, Time to build eytzinger index (ms): " << T.elapsed() << "\n";
+    index.printStats();
+
+    answerPlanned(parameters, valid_pairs_mat, [&](int i, int j) { return filter.mayContain(i, j) && index.queryValue(i, j); }, perm);
+  }
+  else
+  {
+    answerPlanned(parameters, valid_pairs_mat, [&](int i, int j) { return filter.mayContain(i, j) && pairg::matrixOps::queryValue(valid_pairs_mat, i, j); }, perm);
+  }
+}
+
 /**
  * @brief     main function
  */
@@ -36,38 +161,252 @@ int main(int argc, char* argv[])
   //initialize kokkos
   Kokkos::initialize();
 
+  if (parameters.iformat.compare("node") == 0)
   {
     pairg::timer T1;
 
-    //build adjacency matrix from input graph
-    pairg::matrixOps::crsMat_t adj_mat = pairg::getAdjacencyMatrix(parameters);
+    //build index directly on the compacted node graph
+    psgl::graphLoader g;
+    pairg::loadGraph(parameters, g);
+
+    //character-level graph is not used by the node index
+    g.diCharGraph = psgl::CSR_char_container();
+
+    pairg::nodeGraphIndex index;
+    index.build(g.diGraph, parameters);
+    std::cout << "INFO, pairg::main, Time to build node graph index (ms): " << T1.elapsed() << "\n";
+    index.printStats();
+
+    answerQueries(parameters, index.numChars, [&](int i, int j) { return index.queryValue(i, j); });
+  }
+  else if (parameters.iformat.compare("distance") == 0)
+  {
+    pairg::timer T1;
+
+    //build index with feasible path lengths per valid pair
+    pairg::matrixOps::graph_t adj_mat = pairg::getAdjacencyGraph(parameters);
     std::cout << "INFO, pairg::main, Time to build adjacency matrix (ms): " << T1.elapsed() << "\n";
-    pairg::matrixOps::printMatrix(adj_mat, 1);
+
+    //relabel vertices, queries are translated with the permutation
+    pairg::vertexPermutation perm = pairg::reorderVertices(adj_mat, parameters);
 
     pairg::timer T2;
+    pairg::distanceSetIndex index;
+    index.build(adj_mat, parameters);
+    std::cout << "INFO, pairg::main, Time to build distance set index (ms): " << T2.elapsed() << "\n";
+    index.printStats();
 
-    //build index matrix 
-    pairg::matrixOps::crsMat_t valid_pairs_mat = pairg::buildValidPairsMatrix(adj_mat, parameters); 
-    std::cout << "INFO, pairg::main, Time to build result matrix (ms): " << T2.elapsed() << "\n";
-    pairg::matrixOps::printMatrix(valid_pairs_mat, 1);
+    answerQueries(parameters, index.numRows, [&](int i, int j) { return index.queryValue(i, j); }, perm);
+  }
+  else if (parameters.iformat.compare("lazy") == 0)
+  {
+    pairg::timer T1;
+
+    //rows of the index are computed as they are queried
+    pairg::matrixOps::graph_t adj_mat = pairg::getAdjacencyGraph(parameters);
+    std::cout << "INFO, pairg::main, Time to build adjacency matrix (ms): " << T1.elapsed() << "\n";
 
-    //build a set of distance queries
-    std::vector< std::pair<int,int> > random_pairs;
+    //relabel vertices, queries are translated with the permutation
+    pairg::vertexPermutation perm = pairg::reorderVertices(adj_mat, parameters);
+
+    //rows missing from the cache are either built or searched, whichever is predicted cheaper
+    pairg::lazyIndex index (adj_mat, parameters, (std::size_t) parameters.cachesize << 20);
+    pairg::queryPlanner planner (adj_mat, parameters, index);
+    answerQueries(parameters, planner.numVertices, [&](int i, int j) { return planner.queryValue(i, j); }, perm);
+    index.printStats();
+    planner.printStats();
+  }
+  else if (parameters.iformat.compare("bfs") == 0)
+  {
+    pairg::timer T1;
+
+    //no index, each query is answered by a bounded search on the adjacency matrix
+    pairg::matrixOps::graph_t adj_mat = pairg::getAdjacencyGraph(parameters);
+    std::cout << "INFO, pairg::main, Time to build adjacency matrix (ms): " << T1.elapsed() << "\n";
 
-    for(int i = 0; i < parameters.querycount; i++)
+    //relabel vertices, queries are translated with the permutation
+    pairg::vertexPermutation perm = pairg::reorderVertices(adj_mat, parameters);
+
+    pairg::queryPlanner planner (adj_mat, parameters);
+    answerQueries(parameters, planner.numVertices, [&](int i, int j) { return planner.queryValue(i, j); }, perm);
+    planner.printStats();
+  }
+  else if (parameters.windows.size() > 1)
+  {
+    //windows whose index is not available from a saved file yet
+    std::vector<pairg::Parameters> pending;
+
+    for(auto &w : parameters.windows)
     {
-      auto p = getRandomPair (valid_pairs_mat.numRows());
-      random_pairs.push_back(p);
+      pairg::Parameters window = parameters;
+      std::tie(window.d_low, window.d_up) = w;
+
+      if (!parameters.indexfile.empty())
+        window.indexfile = parameters.indexfile + "." + std::to_string(w.first) + "-" + std::to_string(w.second);
+
+      pairg::timer T0;
+      pairg::mappedIndex saved;
+
+      if (!window.indexfile.empty() && saved.open(window.indexfile, pairg::indexFileHeader(window)))
+      {
+        std::cout << "INFO, pairg::main, Time to load index from file (ms): " << T0.elapsed() << "\n";
+        queryPattern(window, saved.graph, pairg::vertexPermutation {saved.permutation});
+      }
+      else
+        pending.push_back(window);
     }
 
-    //answer queries using index
-    std::vector<bool> results_spgemm(parameters.querycount);
-    pairg::timer T3;
-    for(int i = 0; i < parameters.querycount; i++)
+    if (!pending.empty())
     {
-      results_spgemm[i] = pairg::matrixOps::queryValue (valid_pairs_mat, random_pairs[i].first, random_pairs[i].second); 
+      pairg::timer T1;
+
+      //build adjacency matrix (sparsity pattern only) from input graph
+      pairg::matrixOps::graph_t adj_mat = pairg::getAdjacencyGraph(parameters);
+      std::cout << "INFO, pairg::main, Time to build adjacency matrix (ms): " << T1.elapsed() << "\n";
+
+      //relabel vertices, queries are translated with the permutation
+      pairg::vertexPermutation perm = pairg::reorderVertices(adj_mat, parameters);
+      pairg::matrixOps::printMatrix(adj_mat, 1);
+
+      std::vector< std::pair<int,int> > windows;
+      for(auto &window : pending)
+        windows.emplace_back(window.d_low, window.d_up);
+
+      //build index matrices of all windows, sharing the squarings
+      pairg::timer T2;
+      pairg::buildValidPairsGraphs(adj_mat, windows, [&](std::size_t k, const pairg::matrixOps::graph_t &valid_pairs_mat)
+      {
+        pairg::matrixOps::printMatrix(valid_pairs_mat, 1);
+
+        if (!pending[k].indexfile.empty())
+        {
+          pairg::timer T3;
+          pairg::writeIndexFile(pending[k].indexfile, valid_pairs_mat, pairg::indexFileHeader(pending[k]), perm.toNew);
+          std::cout << "INFO, pairg::main, Time to save index (ms): " << T3.elapsed() << "\n";
+        }
+
+        queryPattern(pending[k], valid_pairs_mat, perm);
+      });
+      std::cout << "INFO, pairg::main, Time to build and query " << windows.size() << " windows (ms): " << T2.elapsed() << "\n";
+    }
+  }
+  else
+  {
+    pairg::timer T0;
+    pairg::mappedIndex saved;
+
+    //reuse saved index if it was built for the same graph and distance limits
+    if (!parameters.indexfile.empty() && saved.open(parameters.indexfile, pairg::indexFileHeader(parameters)))
+    {
+      std::cout << "INFO, pairg::main, Time to load index from file (ms): " << T0.elapsed() << "\n";
+      pairg::matrixOps::printMatrix(saved.graph, 1);
+
+      queryPattern(parameters, saved.graph, pairg::vertexPermutation {saved.permutation});
+    }
+    else
+    {
+      pairg::timer T1;
+
+      //build adjacency matrix (sparsity pattern only) from input graph
+      pairg::matrixOps::graph_t adj_mat = pairg::getAdjacencyGraph(parameters);
+      std::cout << "INFO, pairg::main, Time to build adjacency matrix (ms): " << T1.elapsed() << "\n";
+
+      //relabel vertices, queries are translated with the permutation
+      pairg::vertexPermutation perm = pairg::reorderVertices(adj_mat, parameters);
+      pairg::matrixOps::printMatrix(adj_mat, 1);
+
+      pairg::timer T2;
+
+      if (parameters.budget > 0 && !parameters.components)
+      {
+        //stream row panels of the index to disk, query the mapped file
+        pairg::buildValidPairsOutOfCore(adj_mat, parameters, (std::size_t) parameters.budget << 20, parameters.indexfile, perm.toNew);
+        std::cout << "INFO, pairg::main, Time to build index out of core (ms): " << T2.elapsed() << "\n";
+
+        if (!saved.open(parameters.indexfile))
+        {
+          std::cerr << "ERROR, pairg::main, cannot map index file " << parameters.indexfile << std::endl;
+          exit(1);
+        }
+        pairg::matrixOps::printMatrix(saved.graph, 1);
+
+        queryPattern(parameters, saved.graph, perm);
+      }
+      else if (parameters.components)
+      {
+        //one diagonal block per group of components, built one after another,
+        //blocks sized to the memory budget if one is given
+        pairg::componentIndex index;
+        if (parameters.budget > 0)
+          index.build(adj_mat, parameters, pairg::componentIndex::blockVerticesFor(adj_mat, parameters, (std::size_t) parameters.budget << 20));
+        else
+          index.build(adj_mat, parameters);
+        std::cout << "INFO, pairg::main, Time to build index per component (ms): " << T2.elapsed() << "\n";
+        index.printStats();
+
+        if (parameters.iformat.compare("csr") == 0 && parameters.indexfile.empty())
+          answerQueries(parameters, index.numRows, [&](int i, int j) { return index.queryValue(i, j); }, perm);
+        else
+        {
+          //other formats and the index file are built over the whole graph
+          pairg::timer T3;
+          pairg::matrixOps::graph_t valid_pairs_mat = index.toGlobal();
+          std::cout << "INFO, pairg::main, Time to assemble result matrix (ms): " << T3.elapsed() << "\n";
+          pairg::matrixOps::printMatrix(valid_pairs_mat, 1);
+
+          if (!parameters.indexfile.empty())
+          {
+            pairg::timer T4;
+            pairg::writeIndexFile(parameters.indexfile, valid_pairs_mat, pairg::indexFileHeader(parameters), perm.toNew);
+            std::cout << "INFO, pairg::main, Time to save index (ms): " << T4.elapsed() << "\n";
+          }
+
+          queryPattern(parameters, valid_pairs_mat, perm);
+        }
+      }
+      else if (parameters.iformat.compare("interval") == 0 && parameters.indexfile.empty())
+      {
+        //emit run-length encoded rows directly from the final product
+        pairg::matrixOps::graph_t C, D;
+        pairg::buildValidPairsFactors(adj_mat, parameters, C, D);
+
+        pairg::intervalIndex index;
+        index.build(C, D);
+        std::cout << "INFO, pairg::main, Time to build interval index (ms): " << T2.elapsed() << "\n";
+        index.printStats();
+
+        answerQueries(parameters, index.numRows, [&](int i, int j) { return index.queryValue(i, j); }, perm);
+      }
+      else if (parameters.iformat.compare("compressed") == 0 && parameters.indexfile.empty())
+      {
+        //encode rows directly from the final product
+        pairg::matrixOps::graph_t C, D;
+        pairg::buildValidPairsFactors(adj_mat, parameters, C, D);
+
+        pairg::compressedIndex index;
+        index.build(C, D);
+        std::cout << "INFO, pairg::main, Time to build compressed index (ms): " << T2.elapsed() << "\n";
+        index.printStats();
+
+        answerQueries(parameters, index.numRows, [&](int i, int j) { return index.queryValue(i, j); }, perm);
+      }
+      else
+      {
+        //build index matrix 
+        pairg::matrixOps::graph_t valid_pairs_mat = pairg::buildValidPairsGraph(adj_mat, parameters); 
+        std::cout << "INFO, pairg::main, Time to build result matrix (ms): " << T2.elapsed() << "\n";
+        pairg::matrixOps::printMatrix(valid_pairs_mat, 1);
+
+        if (!parameters.indexfile.empty())
+        {
+          pairg::timer T3;
+          pairg::writeIndexFile(parameters.indexfile, valid_pairs_mat, pairg::indexFileHeader(parameters), perm.toNew);
+          std::cout << "INFO, pairg::main, Time to save index (ms): " << T3.elapsed() << "\n";
+        }
+
+        queryPattern(parameters, valid_pairs_mat, perm);
+      }
     }
-    std::cout << "INFO, pairg::main, Time to execute " << parameters.querycount << " queries (ms): " << T3.elapsed() << "\n";
   }
 
   std::cout << std::flush;
@@ -65,5 +65,159 @@ TEST_CASE("building valid-pair matrix for a chain graph")
     }
   }
 
+  SECTION( "distance limits are 10, 50" )
+  {
+    char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", "10", "-u", "50", "-t", "4", "-c", "0", nullptr};
+    int argc = 13;
+
+    pairg::Parameters parameters;        
+    pairg::parseandSave(argc, argv, parameters);
+
+    pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+    pairg::boundedSearch engine (A, parameters);
+
+    REQUIRE(engine.queryValue(0, 0) == false);
+    REQUIRE(engine.queryValue(0, 9) == false);
+    REQUIRE(engine.queryValue(0, 10) == true);
+    REQUIRE(engine.queryValue(0, 50) == true);
+    REQUIRE(engine.queryValue(0, 51) == false);
+    REQUIRE(engine.queryValue(10, 0) == false);
+
+    //repeated queries reuse the same scratch
+    for(int i = 0; i < 1000; i++)
+      REQUIRE(engine.queryValue(i, i + 30) == true);
+  }
+
+  Kokkos::finalize();
+}
+
+
+TEST_CASE("bounded search against valid-pair matrix") 
+{
+  Kokkos::initialize();
+
+  //get file name
+  std::string file = FOLDER;
+  file = file + "/bubble.txt";
+
+  std::vector<char> RFILE(file.c_str(), file.c_str() + file.size() + 1u);
+
+  std::vector< std::pair<std::string, std::string> > limits = {{"0", "0"}, {"0", "3"}, {"2", "9"}, {"5", "12"}, {"7", "7"}};
+
+  for(auto &l : limits)
+  {
+    char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", (char *) l.first.c_str(), "-u", (char *) l.second.c_str(), "-t", "4", "-c", "0", nullptr};
+    int argc = 13;
+
+    pairg::Parameters parameters;        
+    pairg::parseandSave(argc, argv, parameters);
+
+    SECTION( "bubble graph, distance limits are " + l.first + ", " + l.second ) {
+      pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+      pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+
+      pairg::boundedSearch engine (A, parameters);
+
+      //all pairs as one parallel batch
+      int V = A.numRows();
+      pairg::matrixOps::lno_nnz_view_t src ("src", V * V);
+      pairg::matrixOps::lno_nnz_view_t dst ("dst", V * V);
+      pairg::matrixOps::result_view_t results ("results", V * V);
+
+      for(int k = 0; k < V * V; k++)
+      {
+        src(k) = k / V;
+        dst(k) = k % V;
+      }
+
+      pairg::matrixOps::queryBatch([&](int i, int j) { return engine.queryValue(i, j); }, V, src, dst, results);
+
+      for(int k = 0; k < V * V; k++)
+        REQUIRE(results(k) == pairg::matrixOps::queryValue(B, src(k), dst(k)));
+    }
+
+    SECTION( "cyclic graph, distance limits are " + l.first + ", " + l.second ) {
+      //0 -> 1 -> 2 -> 3 -> 0, 2 -> 4 -> 2, 4 -> 5
+      pairg::matrixOps::lno_view_t row_map ("row_map", 7);
+      pairg::matrixOps::lno_nnz_view_t entries ("entries", 7);
+
+      std::vector<int> offsets = {0, 1, 2, 4, 5, 7, 7};
+      std::vector<int> cols = {1, 2, 3, 4, 0, 2, 5};
+      std::copy(offsets.begin(), offsets.end(), row_map.data());
+      std::copy(cols.begin(), cols.end(), entries.data());
+
+      pairg::matrixOps::graph_t A (entries, row_map);
+      REQUIRE(!pairg::matrixOps::isUpperTriangular(A));
+
+      pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+
+      pairg::boundedSearch engine (A, parameters);
+
+      for(int i = 0; i < 6; i++)
+        for(int j = 0; j < 6; j++)
+          REQUIRE(engine.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+    }
+  }
+
+  Kokkos::finalize();
+}
+
+TEST_CASE("matrix powers saturating on a cyclic graph") 
+{
+  Kokkos::initialize();
+
+  //0 -> 1 -> 2 -> 3 -> 0, 2 -> 4 -> 2, 4 -> 5; (A+I)^k stops changing at k = 5
+  pairg::matrixOps::lno_view_t row_map ("row_map", 7);
+  pairg::matrixOps::lno_nnz_view_t entries ("entries", 7);
+
+  std::vector<int> offsets = {0, 1, 2, 4, 5, 7, 7};
+  std::vector<int> cols = {1, 2, 3, 4, 0, 2, 5};
+  std::copy(offsets.begin(), offsets.end(), row_map.data());
+  std::copy(cols.begin(), cols.end(), entries.data());
+
+  pairg::matrixOps::graph_t A (entries, row_map);
+  pairg::matrixOps::graph_t AI = pairg::matrixOps::addGraphs(A, pairg::matrixOps::createIdentityGraph(6));
+
+  REQUIRE(!pairg::matrixOps::hasFullDiagonal(A));
+  REQUIRE(pairg::matrixOps::hasFullDiagonal(AI));
+
+  pairg::matrixOps::graph_t P4 = pairg::matrixOps::power(AI, 4);
+  pairg::matrixOps::graph_t P8 = pairg::matrixOps::power(AI, 8);
+  REQUIRE(!pairg::matrixOps::saturated(P4, P8));
+  REQUIRE(pairg::matrixOps::saturated(P8, pairg::matrixOps::power(AI, 16)));
+
+  std::vector< std::pair<int,int> > windows = {{3, 100}, {0, 64}, {1, 2}, {6, 1000}};
+
+  SECTION( "single window" ) {
+    for(auto &w : windows)
+    {
+      pairg::Parameters parameters;
+      parameters.d_low = w.first;
+      parameters.d_up = w.second;
+
+      pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+      pairg::boundedSearch engine (A, parameters);
+
+      for(int i = 0; i < 6; i++)
+        for(int j = 0; j < 6; j++)
+          REQUIRE(engine.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+    }
+  }
+
+  SECTION( "windows sharing squarings" ) {
+    pairg::buildValidPairsGraphs(A, windows, [&](std::size_t k, const pairg::matrixOps::graph_t &B)
+    {
+      pairg::Parameters parameters;
+      parameters.d_low = windows[k].first;
+      parameters.d_up = windows[k].second;
+
+      pairg::boundedSearch engine (A, parameters);
+
+      for(int i = 0; i < 6; i++)
+        for(int j = 0; j < 6; j++)
+          REQUIRE(engine.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+    });
+  }
+
   Kokkos::finalize();
 }
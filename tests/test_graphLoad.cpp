@@ -133,9 +133,287 @@ TEST_CASE("converting .vg formatted graph to CSR adjacency matrix")
     SECTION( "evaluating matrix content" ) {
       REQUIRE(std::accumulate(A.values.data(), A.values.data() + A.values.extent(0), 0) == E);
       REQUIRE(std::accumulate(A.values.data(), A.values.data() + A.values.extent(0), 1, std::multiplies<int>()) == 1);
+
+      //acyclic graph is relabeled in topological order while decoding
+      REQUIRE(pairg::matrixOps::isUpperTriangular(A.graph));
+    }
+  }
+
+  Kokkos::finalize();
+}
+
+
+TEST_CASE("single-pass ingestion matches graph loader") 
+{
+  Kokkos::initialize();
+
+  //get file name
+  std::string file = FOLDER;
+  file = file + "/chain.txt";
+
+  psgl::graphLoader g;
+  g.loadFromTxt(file);
+
+  //nodes and edges added from several threads
+  pairg::graphIngest ingest;
+
+  #pragma omp parallel for
+  for(int32_t v = 0; v < g.diGraph.numVertices; v++)
+  {
+    ingest.addNode(v, g.diGraph.vertex_metadata[v].length());
+
+    for(auto k = g.diGraph.offsets_out[v]; k < g.diGraph.offsets_out[v+1]; k++)
+      ingest.addEdge(v, g.diGraph.adjcny_out[k]);
+  }
+
+  pairg::matrixOps::graph_t B = pairg::getAdjacencyGraph(g);
+
+  auto sameGraph = [&](const pairg::matrixOps::graph_t &A)
+  {
+    REQUIRE(A.numRows() == B.numRows());
+    REQUIRE(A.entries.extent(0) == B.entries.extent(0));
+    REQUIRE(std::equal(B.row_map.data(), B.row_map.data() + B.numRows() + 1, A.row_map.data()));
+    REQUIRE(std::equal(B.entries.data(), B.entries.data() + B.entries.extent(0), A.entries.data()));
+  };
+
+  SECTION( "nodes and edges added in parallel" ) {
+    sameGraph(ingest.adjacencyGraph());
+  }
+
+  SECTION( "memory-mapped .txt parser" ) {
+    sameGraph(pairg::ingestTxt(file));
+  }
+
+  SECTION( "carriage returns and missing final newline" ) {
+    std::string tmp = "test_graphLoad.txt";
+    {
+      std::ofstream out(tmp);
+      out << "3\r\n1 2 ACG\r\n  2\tT \r\nGG";
     }
+
+    pairg::matrixOps::graph_t A = pairg::ingestTxt(tmp);
+    std::remove(tmp.c_str());
+
+    //characters 0..2 (ACG), 3 (T), 4..5 (GG)
+    std::vector<int> offsets = {0, 1, 2, 4, 5, 6, 6};
+    std::vector<int> cols = {1, 2, 3, 4, 4, 5};
+
+    REQUIRE(A.numRows() == 6);
+    REQUIRE(std::equal(offsets.begin(), offsets.end(), A.row_map.data()));
+    REQUIRE(std::equal(cols.begin(), cols.end(), A.entries.data()));
   }
 
   Kokkos::finalize();
 }
 
+TEST_CASE("loading .gfa formatted graph") 
+{
+  Kokkos::initialize();
+
+  //get file name
+  std::string file = FOLDER;
+  file = file + "/chain.txt";
+
+  psgl::graphLoader g;
+  g.loadFromTxt(file);
+  auto &graph = g.diGraph;
+
+  //same graph as gfa, links alternate between (+, +) and reversed (-, -)
+  std::string tmp = "test_graphLoad.gfa";
+  {
+    std::ofstream out(tmp);
+    out << "H\tVN:Z:1.0\n";
+
+    for(int32_t v = 0; v < graph.numVertices; v++)
+      out << "S\tseg" << v << "\t" << graph.vertex_metadata[v] << "\n";
+
+    int links = 0;
+    for(int32_t v = 0; v < graph.numVertices; v++)
+      for(auto k = graph.offsets_out[v]; k < graph.offsets_out[v+1]; k++, links++)
+        if (links % 2 == 0)
+          out << "L\tseg" << v << "\t+\tseg" << graph.adjcny_out[k] << "\t+\t0M\n";
+        else
+          out << "L\tseg" << graph.adjcny_out[k] << "\t-\tseg" << v << "\t-\t*\n";
+
+    out << "P\tpath\tseg0+\t*\n";
+  }
+
+  std::vector<char> RFILE(tmp.c_str(), tmp.c_str() + tmp.size() + 1u);
+
+  char *argv[] = {"pairmap2graph", "-m", "gfa", "-r", RFILE.data(), "-l", "1", "-u", "2", "-c", "0", "-t", "4", nullptr};
+  int argc = 13;
+
+  pairg::Parameters parameters;        
+  pairg::parseandSave(argc, argv, parameters);
+
+  pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+  pairg::matrixOps::graph_t B = pairg::getAdjacencyGraph(g);
+  std::remove(tmp.c_str());
+
+  SECTION( "evaluating matrix content" ) {
+    REQUIRE(A.numRows() == B.numRows());
+    REQUIRE(A.entries.extent(0) == B.entries.extent(0));
+    REQUIRE(std::equal(B.row_map.data(), B.row_map.data() + B.numRows() + 1, A.row_map.data()));
+    REQUIRE(std::equal(B.entries.data(), B.entries.data() + B.entries.extent(0), A.entries.data()));
+  }
+
+  Kokkos::finalize();
+}
+
+TEST_CASE("ingestion is reproducible on a branching graph") 
+{
+  Kokkos::initialize();
+
+  //one node fans out to 2000 nodes, which merge again through 7 nodes
+  //into a sink
+  std::vector<std::pair<int, int>> edges;
+  for(int v = 1; v <= 2000; v++)
+  {
+    edges.emplace_back(0, v);
+    edges.emplace_back(v, 2001 + v % 7);
+  }
+  for(int v = 2001; v < 2008; v++)
+    edges.emplace_back(v, 2008);
+
+  //edges arrive in a different order in each run, as they do when several
+  //threads parse a file
+  auto ingestInOrder = [&](int seed)
+  {
+    std::mt19937 gen(seed);
+    std::shuffle(edges.begin(), edges.end(), gen);
+
+    pairg::graphIngest ingest;
+    for(int v = 0; v <= 2008; v++)
+      ingest.addNode(v, v % 2 ? 2 : 1);
+    for(auto &e : edges)
+      ingest.addEdge(e.first, e.second);
+
+    return ingest.adjacencyGraph();
+  };
+
+  pairg::matrixOps::graph_t B = ingestInOrder(0);
+
+  SECTION( "vertex ids do not depend on the order of edges" ) {
+    for(int seed = 1; seed < 8; seed++)
+    {
+      pairg::matrixOps::graph_t A = ingestInOrder(seed);
+
+      REQUIRE(A.numRows() == B.numRows());
+      REQUIRE(A.entries.extent(0) == B.entries.extent(0));
+      REQUIRE(std::equal(B.row_map.data(), B.row_map.data() + B.numRows() + 1, A.row_map.data()));
+      REQUIRE(std::equal(B.entries.data(), B.entries.data() + B.entries.extent(0), A.entries.data()));
+    }
+
+    REQUIRE(pairg::matrixOps::isUpperTriangular(B));
+  }
+
+  Kokkos::finalize();
+}
+
+TEST_CASE("ingestion picks the same topological order as graph loader") 
+{
+  Kokkos::initialize();
+
+  //one node fans out to 500 nodes, which merge again through 7 nodes into
+  //a sink, ids shuffled so that relabeling is needed
+  int n = 509;
+  std::vector<int> id (n);
+  std::iota(id.begin(), id.end(), 0);
+  std::mt19937 gen(3);
+  std::shuffle(id.begin(), id.end(), gen);
+
+  std::vector< std::vector<int> > out (n);
+  for(int v = 1; v <= 500; v++)
+  {
+    out[id[0]].push_back(id[v]);
+    out[id[v]].push_back(id[501 + v % 7]);
+  }
+  for(int v = 501; v < 508; v++)
+    out[id[v]].push_back(id[508]);
+  for(auto &o : out)
+    std::sort(o.begin(), o.end());
+
+  auto length = [](int v) { return v % 2 ? 2 : 1; };
+
+  std::string tmp = "test_graphLoad.txt";
+  {
+    std::ofstream f(tmp);
+    f << n << "\n";
+    for(int v = 0; v < n; v++)
+    {
+      for(int w : out[v])
+        f << w << " ";
+      f << (length(v) == 2 ? "AC" : "G") << "\n";
+    }
+  }
+
+  pairg::matrixOps::graph_t A = pairg::ingestTxt(tmp);
+  std::remove(tmp.c_str());
+
+  //psgl::CSR_container::sort with a generator of its own instead of psgl's
+  //function-local static: one Kahn run to detect cycles, one for the order,
+  //ties picked by psgl::random::select over a list
+  std::mt19937 psglGen(41);
+  auto kahn = [&]()
+  {
+    std::vector<int> deg (n, 0), order;
+    for(auto &o : out)
+      for(int w : o)
+        deg[w]++;
+
+    std::list<int> Q;
+    for(int v = 0; v < n; v++)
+      if (deg[v] == 0)
+        Q.emplace_back(v);
+
+    while (!Q.empty())
+    {
+      auto it = psgl::random::select(Q.begin(), Q.end(), psglGen);
+      int v = *it;
+      Q.erase(it);
+      order.push_back(v);
+
+      for(int w : out[v])
+        if (--deg[w] == 0)
+          Q.emplace_back(w);
+    }
+
+    return order;
+  };
+
+  kahn();
+  std::vector<int> order = kahn();
+  REQUIRE(order.size() == n);
+
+  //character-level pattern in that order, as psgl::CSR_char_container builds it
+  std::vector<int> first (n);
+  for(int r = 0, c = 0; r < n; c += length(order[r]), r++)
+    first[order[r]] = c;
+
+  std::vector<std::size_t> row_map (1, 0);
+  std::vector<int> entries;
+  for(int v : order)
+  {
+    for(int c = first[v]; c < first[v] + length(v) - 1; c++)
+    {
+      entries.push_back(c + 1);
+      row_map.push_back(entries.size());
+    }
+
+    std::vector<int> next;
+    for(int w : out[v])
+      next.push_back(first[w]);
+    std::sort(next.begin(), next.end());
+    entries.insert(entries.end(), next.begin(), next.end());
+    row_map.push_back(entries.size());
+  }
+
+  SECTION( "evaluating matrix content" ) {
+    REQUIRE(A.numRows() + 1 == row_map.size());
+    REQUIRE(A.entries.extent(0) == entries.size());
+    REQUIRE(std::equal(row_map.begin(), row_map.end(), A.row_map.data()));
+    REQUIRE(std::equal(entries.begin(), entries.end(), A.entries.data()));
+  }
+
+  Kokkos::finalize();
+}
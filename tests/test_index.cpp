@@ -0,0 +1,855 @@
+/**
+ * @file    test_index.hpp
+ * @author  Chirag Jain <cjain7@gatech.edu>
+ */
+
+#include "reachability.hpp"
+#include "hybrid_index.hpp"
+#include "node_index.hpp"
+#include "interval_index.hpp"
+#include "compressed_index.hpp"
+#include "eytzinger_index.hpp"
+#include "row_filter.hpp"
+#include "distance_index.hpp"
+#include "incremental_update.hpp"
+#include "lazy_index.hpp"
+#include "query_planner.hpp"
+#include "index_file.hpp"
+#include "reorder.hpp"
+#include "component_index.hpp"
+
+//External includes
+#include "catch/single_include/catch2/catch.hpp"
+
+#define QUOTE(name) #name
+#define STR(macro) QUOTE(macro)
+#define FOLDER STR(PROJECT_TEST_DATA_DIR)
+
+TEST_CASE("alternative index formats for a chain graph") 
+{
+  Kokkos::initialize();
+
+  //get file name
+  std::string file = FOLDER;
+  file = file + "/chain.txt";
+
+  std::vector<char> RFILE(file.c_str(), file.c_str() + file.size() + 1u);
+
+  char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", "10", "-u", "200", "-t", "4", "-c", "0", nullptr};
+  int argc = 13;
+
+  pairg::Parameters parameters;        
+  pairg::parseandSave(argc, argv, parameters);
+
+  int V = 81189;
+
+  pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+  pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+
+  //sample of (src, dst) pairs around the diagonal and far away from it
+  std::vector< std::pair<int,int> > pairs;
+  for(int i = 0; i < V; i += 97)
+    for(int d = -3; d <= 210; d += 7)
+      if (i + d >= 0 && i + d < V)
+        pairs.emplace_back(i, i + d);
+  pairs.emplace_back(0, V - 1);
+  pairs.emplace_back(V - 1, 0);
+
+  SECTION( "hybrid sparse/bitmap rows" ) {
+    pairg::hybridIndex index;
+    index.build(B);
+
+    REQUIRE(index.numRows == V);
+    REQUIRE(index.denseRowCount() > 0);
+    REQUIRE(index.memoryBytes() < B.entries.extent(0) * sizeof(pairg::matrixOps::lno_t));
+
+    for(auto &p : pairs)
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    REQUIRE(index.queryValue(0, 10) == true);
+    REQUIRE(index.queryValue(0, 200) == true);
+    REQUIRE(index.queryValue(0, 9) == false);
+    REQUIRE(index.queryValue(0, 201) == false);
+  }
+
+  SECTION( "run-length encoded rows" ) {
+    pairg::intervalIndex index;
+    index.build(B);
+
+    //one run per non-empty row on a chain graph
+    REQUIRE(index.numRows == V);
+    REQUIRE(index.run_start.extent(0) == V - 10);
+
+    for(auto &p : pairs)
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    //emitting runs directly from the factors gives the same index
+    pairg::matrixOps::graph_t C, D;
+    pairg::buildValidPairsFactors(A, parameters, C, D);
+
+    pairg::intervalIndex index2;
+    index2.build(C, D);
+
+    REQUIRE(index2.run_start.extent(0) == index.run_start.extent(0));
+    REQUIRE(std::equal(index2.row_map.data(), index2.row_map.data() + V + 1, index.row_map.data()));
+    REQUIRE(std::equal(index2.run_start.data(), index2.run_start.data() + index.run_start.extent(0), index.run_start.data()));
+    REQUIRE(std::equal(index2.run_length.data(), index2.run_length.data() + index.run_length.extent(0), index.run_length.data()));
+  }
+
+  SECTION( "delta + varint compressed rows" ) {
+    pairg::compressedIndex index;
+    index.build(B);
+
+    REQUIRE(index.numRows == V);
+    REQUIRE(index.row_map(V) == B.entries.extent(0));
+    REQUIRE(index.memoryBytes() < B.entries.extent(0) * sizeof(pairg::matrixOps::lno_t) / 2);
+
+    for(auto &p : pairs)
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    std::vector<pairg::matrixOps::lno_t> cols;
+    for(int i = 0; i < V; i += 1013)
+    {
+      index.decodeRow(i, cols);
+      REQUIRE(std::equal(cols.begin(), cols.end(), B.entries.data() + B.row_map(i)));
+    }
+
+    //encoding rows directly from the factors gives the same index
+    pairg::matrixOps::graph_t C, D;
+    pairg::buildValidPairsFactors(A, parameters, C, D);
+
+    pairg::compressedIndex index2;
+    index2.build(C, D);
+
+    REQUIRE(index2.data.extent(0) == index.data.extent(0));
+    REQUIRE(std::equal(index2.block_map.data(), index2.block_map.data() + V + 1, index.block_map.data()));
+    REQUIRE(std::equal(index2.block_offset.data(), index2.block_offset.data() + index.block_offset.extent(0), index.block_offset.data()));
+    REQUIRE(std::equal(index2.data.data(), index2.data.data() + index.data.extent(0), index.data.data()));
+  }
+
+  SECTION( "rows in Eytzinger order" ) {
+    pairg::eytzingerIndex index;
+    index.build(B);
+
+    //rows have 191 columns, except near the end of the chain
+    REQUIRE(index.numRows == V);
+    REQUIRE(index.treeRowCount() == V - 10 - 64);
+
+    for(auto &p : pairs)
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    //every column of a sample of rows, and its neighbours
+    for(int i = 0; i < V; i += 997)
+      for(int j = i; j <= i + 201 && j < V; j++)
+        REQUIRE(index.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+
+    //rows near the end of the chain cover every row length, i.e., every tree shape
+    for(int i = V - 201; i < V; i++)
+      for(int j = i; j < V; j++)
+        REQUIRE(index.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+  }
+
+  SECTION( "row filter" ) {
+    pairg::rowFilter filter;
+    filter.build(B);
+
+    //rows of a chain graph are contiguous, filter is exact
+    for(auto &p : pairs)
+      if (p.first < V && p.second < V)
+        REQUIRE(filter.mayContain(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    //empty rows reject everything
+    REQUIRE(filter.mayContain(V - 1, V - 1) == false);
+    REQUIRE(filter.mayContain(V - 1, 0) == false);
+  }
+
+  SECTION( "feasible distances per valid pair" ) {
+    pairg::distanceSetIndex index;
+    index.build(A, parameters);
+
+    REQUIRE(index.words == 3);
+    REQUIRE(index.entries.extent(0) == B.entries.extent(0));
+
+    for(auto &p : pairs)
+    {
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+      //single path on a chain graph
+      std::vector<int> expected;
+      if (index.queryValue(p.first, p.second))
+        expected.push_back(p.second - p.first);
+      REQUIRE(index.distances(p.first, p.second) == expected);
+    }
+  }
+
+  SECTION( "rows computed on demand" ) {
+    //room for about 40 rows of 191 columns
+    pairg::lazyIndex index (A, parameters, 64 * 40 * (191 * 4 + 96));
+
+    for(auto &p : pairs)
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    REQUIRE(index.cachedBytes() <= 64 * 40 * (191 * 4 + 96));
+
+    //repeated queries on a row hit the cache
+    auto row = index.getRow(500);
+    REQUIRE(std::equal(row->begin(), row->end(), B.entries.data() + B.row_map(500)));
+    REQUIRE(row->size() == B.row_map(501) - B.row_map(500));
+    REQUIRE(index.getRow(500) == row);
+
+    //parallel queries through the batch API
+    int count = pairs.size();
+    pairg::matrixOps::lno_nnz_view_t src ("src", count);
+    pairg::matrixOps::lno_nnz_view_t dst ("dst", count);
+    pairg::matrixOps::result_view_t results ("results", count);
+    for(int k = 0; k < count; k++)
+      std::tie(src(k), dst(k)) = pairs[k];
+
+    pairg::matrixOps::queryBatch([&](int i, int j) { return index.queryValue(i, j); }, V, src, dst, results, true);
+
+    for(int k = 0; k < count; k++)
+      REQUIRE(results(k) == pairg::matrixOps::queryValue(B, src(k), dst(k)));
+  }
+
+  SECTION( "query planner" ) {
+    pairg::lazyIndex lazy (A, parameters, 1 << 20);
+
+    pairg::queryPlanner withIndex (A, parameters, B);
+    pairg::queryPlanner withLazy (A, parameters, lazy);
+    pairg::queryPlanner searchOnly (A, parameters);
+
+    //each row twice: searched first, then built into the cache, then cached
+    for(int repeat = 0; repeat < 3; repeat++)
+      for(auto &p : pairs)
+      {
+        bool expected = pairg::matrixOps::queryValue(B, p.first, p.second);
+        REQUIRE(withIndex.queryValue(p.first, p.second) == expected);
+        REQUIRE(withLazy.queryValue(p.first, p.second) == expected);
+        REQUIRE(searchOnly.queryValue(p.first, p.second) == expected);
+      }
+
+    //chain graph is acyclic, targets before the source are rejected by order
+    REQUIRE(withIndex.queries(pairg::queryPlanner::ORDER) > 0);
+    REQUIRE(withIndex.queries(pairg::queryPlanner::ORDER) + withIndex.queries(pairg::queryPlanner::LOOKUP) == 3 * pairs.size());
+    REQUIRE(searchOnly.queries(pairg::queryPlanner::ORDER) + searchOnly.queries(pairg::queryPlanner::SEARCH) == 3 * pairs.size());
+
+    REQUIRE(withLazy.queries(pairg::queryPlanner::LOOKUP) == 0);
+    REQUIRE(withLazy.queries(pairg::queryPlanner::SEARCH) > 0);
+    REQUIRE(withLazy.queries(pairg::queryPlanner::BUILD_ROW) > 0);
+    REQUIRE(withLazy.queries(pairg::queryPlanner::CACHED_ROW) > 0);
+
+    //complete index in another row format, planned from the shape of the pattern
+    pairg::intervalIndex interval;
+    interval.build(B);
+    pairg::queryPlanner withFormat (parameters, B);
+    auto lookup = [&](int i, int j) { return interval.queryValue(i, j); };
+
+    for(auto &p : pairs)
+      REQUIRE(withFormat.queryValue(p.first, p.second, lookup) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    REQUIRE(withFormat.queries(pairg::queryPlanner::ORDER) == withIndex.queries(pairg::queryPlanner::ORDER) / 3);
+    REQUIRE(withFormat.queries(pairg::queryPlanner::ORDER) + withFormat.queries(pairg::queryPlanner::LOOKUP) == pairs.size());
+  }
+
+  SECTION( "batched queries" ) {
+    int count = pairs.size() + 2;
+    pairg::matrixOps::lno_nnz_view_t src ("src", count);
+    pairg::matrixOps::lno_nnz_view_t dst ("dst", count);
+    pairg::matrixOps::result_view_t results ("results", count);
+
+    //pairs in reverse order, two queries out of range
+    for(std::size_t k = 0; k < pairs.size(); k++)
+      std::tie(src(k), dst(k)) = pairs[pairs.size() - 1 - k];
+    std::tie(src(count - 2), dst(count - 2)) = std::make_pair(V, 0);
+    std::tie(src(count - 1), dst(count - 1)) = std::make_pair(0, -1);
+
+    auto query = [&](int i, int j) { return pairg::matrixOps::queryValue(B, i, j); };
+
+    for(bool sortByRow : {false, true})
+    {
+      Kokkos::deep_copy(results, (uint8_t) 2);
+      REQUIRE(pairg::matrixOps::queryBatch(query, V, src, dst, results, sortByRow) == 2);
+
+      for(int k = 0; k < count - 2; k++)
+        REQUIRE(results(k) == pairg::matrixOps::queryValue(B, src(k), dst(k)));
+      REQUIRE(results(count - 2) == 0);
+      REQUIRE(results(count - 1) == 0);
+    }
+  }
+
+  SECTION( "index on compacted node graph" ) {
+    psgl::graphLoader g;
+    pairg::loadGraph(parameters, g);
+
+    pairg::nodeGraphIndex index;
+    index.build(g.diGraph, parameters);
+
+    REQUIRE(index.numNodes == 1160);
+    REQUIRE(index.numChars == V);
+
+    for(auto &p : pairs)
+      REQUIRE(index.queryValue(p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    //base ids agree with the character graph built by the loader
+    for(int i = 0; i < V; i += 101)
+    {
+      int u = index.nodeOf(i);
+      REQUIRE(g.diCharGraph.originalVertexId[i].first == g.diGraph.originalVertexId[u]);
+      REQUIRE(g.diCharGraph.originalVertexId[i].second == i - index.node_start(u));
+    }
+  }
+
+  SECTION( "vertex reordering" ) {
+    for(std::string order : {"rcm", "bfs", "topo"})
+    {
+      pairg::Parameters reordered = parameters;
+      reordered.vorder = order;
+
+      pairg::matrixOps::graph_t A2 = A;
+      pairg::vertexPermutation perm = pairg::reorderVertices(A2, reordered);
+
+      //a permutation of all vertices
+      REQUIRE(perm.toNew.extent(0) == V);
+      std::vector<bool> hit (V, false);
+      for(int v = 0; v < V; v++)
+        hit[perm(v)] = true;
+      REQUIRE(std::count(hit.begin(), hit.end(), true) == V);
+
+      //chain stays a path of consecutive ids, in topological order
+      REQUIRE(pairg::meanBandwidth(A2) == 1.0);
+      REQUIRE(pairg::matrixOps::isUpperTriangular(A2));
+
+      pairg::matrixOps::graph_t B2 = pairg::buildValidPairsGraph(A2, reordered);
+      REQUIRE(B2.entries.extent(0) == B.entries.extent(0));
+
+      for(auto &p : pairs)
+        REQUIRE(pairg::matrixOps::queryValue(B2, perm(p.first), perm(p.second)) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+      //permutation is saved with the index
+      std::string indexfile = "test_index_" + order + ".pairg";
+      pairg::writeIndexFile(indexfile, B2, pairg::indexFileHeader(reordered), perm.toNew);
+
+      pairg::mappedIndex saved;
+      REQUIRE(!saved.open(indexfile, pairg::indexFileHeader(parameters)));
+      REQUIRE(saved.open(indexfile, pairg::indexFileHeader(reordered)));
+      REQUIRE(std::equal(perm.toNew.data(), perm.toNew.data() + V, saved.permutation.data()));
+
+      pairg::vertexPermutation loaded {saved.permutation};
+      for(auto &p : pairs)
+        REQUIRE(pairg::matrixOps::queryValue(saved.graph, loaded(p.first), loaded(p.second)) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+      std::remove(indexfile.c_str());
+    }
+  }
+
+  SECTION( "out-of-core build, queried through memory-mapped file" ) {
+    std::string indexfile = "test_index.pairg";
+
+    //budget of 64 KB forces many row panels
+    pairg::buildValidPairsOutOfCore(A, parameters, 64 << 10, indexfile);
+
+    pairg::mappedIndex index;
+    REQUIRE(index.open(indexfile));
+    REQUIRE(index.graph.numRows() == V);
+    REQUIRE(index.graph.entries.extent(0) == B.entries.extent(0));
+    REQUIRE(std::equal(index.graph.row_map.data(), index.graph.row_map.data() + V + 1, B.row_map.data()));
+    REQUIRE(std::equal(index.graph.entries.data(), index.graph.entries.data() + B.entries.extent(0), B.entries.data()));
+
+    for(auto &p : pairs)
+      REQUIRE(pairg::matrixOps::queryValue(index.graph, p.first, p.second) == pairg::matrixOps::queryValue(B, p.first, p.second));
+
+    //in-memory index written to file maps back to the same pattern
+    std::string indexfile2 = "test_index2.pairg";
+    pairg::writeIndexFile(indexfile2, B, pairg::indexFileHeader(parameters));
+
+    pairg::mappedIndex index2;
+    REQUIRE(index2.open(indexfile2));
+    REQUIRE(std::equal(index2.graph.entries.data(), index2.graph.entries.data() + B.entries.extent(0), B.entries.data()));
+
+    //writes through the views stay private to the mapping
+    index2.graph.entries(0) = V;
+    REQUIRE(index2.open(indexfile2));
+    REQUIRE(index2.graph.entries(0) == B.entries(0));
+
+    //saved index is reused only for the same graph and distance limits
+    pairg::indexFileHeader expected (parameters);
+    REQUIRE(index2.header.version == pairg::indexFileHeader::currentVersion());
+    REQUIRE(index2.open(indexfile2, expected));
+
+    pairg::indexFileHeader other = expected;
+    other.d_up++;
+    REQUIRE(!index2.open(indexfile2, other));
+
+    other = expected;
+    other.graphChecksum++;
+    REQUIRE(!index2.open(indexfile2, other));
+
+    //checksum covers every byte, also past the first chunk
+    {
+      std::string data ((3 << 20) + 5, 'a');
+      std::ofstream("test_checksum.txt") << data;
+      uint64_t h = pairg::indexFileHeader::fileChecksum("test_checksum.txt");
+      REQUIRE(pairg::indexFileHeader::fileChecksum("test_checksum.txt") == h);
+
+      data[(2 << 20) + 3] = 'b';
+      std::ofstream("test_checksum.txt") << data;
+      uint64_t h2 = pairg::indexFileHeader::fileChecksum("test_checksum.txt");
+      REQUIRE(h2 != h);
+
+      std::ofstream("test_checksum.txt") << data << 'a';
+      REQUIRE(pairg::indexFileHeader::fileChecksum("test_checksum.txt") != h2);
+      std::remove("test_checksum.txt");
+    }
+
+    std::remove(indexfile.c_str());
+    std::remove(indexfile2.c_str());
+  }
+
+  Kokkos::finalize();
+}
+
+
+TEST_CASE("incremental update after adding variants to a chain graph") 
+{
+  Kokkos::initialize();
+
+  //get file name
+  std::string file = FOLDER;
+  file = file + "/chain.txt";
+
+  std::vector<char> RFILE(file.c_str(), file.c_str() + file.size() + 1u);
+
+  char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", "10", "-u", "50", "-t", "4", "-c", "0", nullptr};
+  int argc = 13;
+
+  pairg::Parameters parameters;        
+  pairg::parseandSave(argc, argv, parameters);
+
+  int V = 81189;
+
+  pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+  pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+
+  //a deletion, a SNP-like bubble, a removed edge, and an insertion of 3 new bases
+  pairg::graphDelta delta;
+  delta.numVertices = V + 3;
+  delta.addedEdges = {{1000, 1002}, {5000, 5003}, {30000, V}, {V, V + 1}, {V + 1, V + 2}, {V + 2, 30001}};
+  delta.removedEdges = {{20000, 20001}};
+
+  //reference: full rebuild on the changed graph
+  pairg::matrixOps::graph_t A_ref = pairg::applyDelta(A, delta);
+  pairg::matrixOps::graph_t B_ref = pairg::buildValidPairsGraph(A_ref, parameters); 
+
+  REQUIRE(A_ref.numRows() == V + 3);
+  REQUIRE(A_ref.entries.extent(0) == A.entries.extent(0) + 5);
+
+  SECTION( "affected rows lie within d_up upstream of the change" ) {
+    std::vector<pairg::matrixOps::lno_t> rows = pairg::affectedRows(A_ref, V, delta, parameters);
+
+    //50 rows upstream of each of the 4 changed sources (1000, 5000, 20000, 30000), 3 new vertices,
+    //and rows of the inserted path upstream of its last base
+    REQUIRE(rows.size() == 4 * 50 + 3);
+    REQUIRE(std::binary_search(rows.begin(), rows.end(), 951));
+    REQUIRE(!std::binary_search(rows.begin(), rows.end(), 950));
+    REQUIRE(!std::binary_search(rows.begin(), rows.end(), 1001));
+  }
+
+  SECTION( "updated pattern equals a full rebuild" ) {
+    pairg::matrixOps::graph_t A_new;
+    pairg::matrixOps::graph_t B_new = pairg::updateValidPairsGraph(B, A, delta, parameters, A_new);
+
+    REQUIRE(B_new.numRows() == V + 3);
+    REQUIRE(B_new.entries.extent(0) == B_ref.entries.extent(0));
+    REQUIRE(std::equal(B_new.row_map.data(), B_new.row_map.data() + V + 4, B_ref.row_map.data()));
+    REQUIRE(std::equal(B_new.entries.data(), B_new.entries.data() + B_ref.entries.extent(0), B_ref.entries.data()));
+
+    //new paths through the variants
+    REQUIRE(pairg::matrixOps::queryValue(B, 4990, 5042) == false);
+    REQUIRE(pairg::matrixOps::queryValue(B_new, 4990, 5042) == true);
+    REQUIRE(pairg::matrixOps::queryValue(B, 19995, 20010) == true);
+    REQUIRE(pairg::matrixOps::queryValue(B_new, 19995, 20010) == false);
+    REQUIRE(pairg::matrixOps::queryValue(B_new, 29990, V + 2) == true);
+  }
+
+  SECTION( "saved index is updated in place" ) {
+    std::string indexfile = "test_update.pairg";
+    pairg::writeIndexFile(indexfile, B, pairg::indexFileHeader(parameters));
+
+    pairg::matrixOps::graph_t A_new = pairg::updateIndexFile(indexfile, A, delta, parameters);
+    REQUIRE(A_new.entries.extent(0) == A_ref.entries.extent(0));
+
+    pairg::mappedIndex index;
+    REQUIRE(index.open(indexfile, pairg::indexFileHeader(parameters)));
+    REQUIRE(index.graph.numRows() == V + 3);
+    REQUIRE(std::equal(index.graph.entries.data(), index.graph.entries.data() + B_ref.entries.extent(0), B_ref.entries.data()));
+
+    std::remove(indexfile.c_str());
+  }
+
+  SECTION( "saved index is patched in place if row lengths are unchanged" ) {
+    std::string indexfile = "test_update.pairg";
+    pairg::writeIndexFile(indexfile, B, pairg::indexFileHeader(parameters));
+
+    struct stat before;
+    REQUIRE(stat(indexfile.c_str(), &before) == 0);
+
+    //40000 -> 40002 bypasses 40001, every row upstream keeps 41 columns
+    pairg::graphDelta bypass;
+    bypass.numVertices = V;
+    bypass.addedEdges = {{40000, 40002}};
+    bypass.removedEdges = {{40000, 40001}};
+
+    pairg::matrixOps::graph_t A_new = pairg::updateIndexFile(indexfile, A, bypass, parameters);
+    pairg::matrixOps::graph_t B_new = pairg::buildValidPairsGraph(A_new, parameters);
+
+    //same file, not replaced by a new one
+    struct stat after;
+    REQUIRE(stat(indexfile.c_str(), &after) == 0);
+    REQUIRE(after.st_ino == before.st_ino);
+
+    pairg::mappedIndex index;
+    REQUIRE(index.open(indexfile, pairg::indexFileHeader(parameters)));
+    REQUIRE(index.graph.entries.extent(0) == B_new.entries.extent(0));
+    REQUIRE(std::equal(index.graph.row_map.data(), index.graph.row_map.data() + V + 1, B_new.row_map.data()));
+    REQUIRE(std::equal(index.graph.entries.data(), index.graph.entries.data() + B_new.entries.extent(0), B_new.entries.data()));
+    REQUIRE(pairg::matrixOps::queryValue(index.graph, 39995, 40001) == false);
+
+    //header of an update interrupted before its rows were written, not reused
+    pairg::indexFileHeader interrupted = index.header;
+    interrupted.graphChecksum = 0;
+    {
+      std::fstream f (indexfile, std::ios::in | std::ios::out | std::ios::binary);
+      f.write((const char*) &interrupted, sizeof(interrupted));
+    }
+
+    pairg::mappedIndex stale;
+    REQUIRE(!stale.open(indexfile, pairg::indexFileHeader(parameters)));
+
+    std::remove(indexfile.c_str());
+  }
+
+  SECTION( "saved index is checked against the vertex ids of the graph" ) {
+    REQUIRE(pairg::sameVertexIds(B, A, {}, parameters));
+
+    //on a chain, the transpose is the same graph with reversed vertex ids
+    pairg::matrixOps::graph_t reversed = pairg::matrixOps::transposeGraph(A);
+    REQUIRE(!pairg::sameVertexIds(B, reversed, {}, parameters));
+  }
+
+  Kokkos::finalize();
+}
+
+
+TEST_CASE("index on compacted node graph for a bubble graph") 
+{
+  Kokkos::initialize();
+
+  //get file name
+  std::string file = FOLDER;
+  file = file + "/bubble.txt";
+
+  std::vector<char> RFILE(file.c_str(), file.c_str() + file.size() + 1u);
+
+  std::vector< std::pair<std::string, std::string> > limits = {{"0", "0"}, {"0", "3"}, {"2", "9"}, {"5", "12"}, {"7", "7"}, {"0", "30"}};
+
+  for(auto &l : limits)
+  {
+    char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", (char *) l.first.c_str(), "-u", (char *) l.second.c_str(), "-t", "4", "-c", "0", nullptr};
+    int argc = 13;
+
+    pairg::Parameters parameters;        
+    pairg::parseandSave(argc, argv, parameters);
+
+    //topological order is randomized, both indices must use the same loaded graph
+    psgl::graphLoader g;
+    pairg::loadGraph(parameters, g);
+
+    //per-character index as reference
+    pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(g);
+    pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+
+    //topological sweep of the acyclic graph matches the matrix powers
+    REQUIRE(pairg::matrixOps::isUpperTriangular(A));
+    {
+      pairg::matrixOps::graph_t C, D;
+      pairg::buildValidPairsFactors(A, parameters, C, D);
+      pairg::matrixOps::graph_t E = pairg::matrixOps::multiplyFactors(C, D);
+      pairg::matrixOps::graph_t S = pairg::buildValidPairsGraphDAG(A, parameters);
+
+      REQUIRE(std::equal(S.row_map.data(), S.row_map.data() + S.row_map.extent(0), E.row_map.data()));
+      REQUIRE(std::equal(S.entries.data(), S.entries.data() + S.entries.extent(0), E.entries.data()));
+    }
+
+    pairg::nodeGraphIndex index;
+    index.build(g.diGraph, parameters);
+
+    REQUIRE(index.numChars == A.numRows());
+
+    for(int i = 0; i < index.numChars; i++)
+      for(int j = 0; j < index.numChars; j++)
+        REQUIRE(index.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+
+    //feasible distances, compared against exact powers of A
+    pairg::distanceSetIndex dindex;
+    dindex.build(A, parameters);
+
+    std::vector<pairg::matrixOps::graph_t> P;
+    for(int d = parameters.d_low; d <= parameters.d_up; d++)
+      P.push_back(pairg::matrixOps::power(A, d));
+
+    for(int i = 0; i < index.numChars; i++)
+      for(int j = 0; j < index.numChars; j++)
+      {
+        std::vector<int> expected;
+        for(int d = parameters.d_low; d <= parameters.d_up; d++)
+          if (pairg::matrixOps::queryValue(P[d - parameters.d_low], i, j))
+            expected.push_back(d);
+
+        REQUIRE(dindex.distances(i, j) == expected);
+        REQUIRE(dindex.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+      }
+  }
+
+  Kokkos::finalize();
+}
+
+
+TEST_CASE("index per weakly connected component") 
+{
+  Kokkos::initialize();
+
+  typedef pairg::matrixOps::lno_t lno_t;
+
+  //three components with interleaved ids (v % 3): a cycle, a chain, and a chain
+  //with edges skipping a vertex; the last vertex is isolated
+  int V = 301;
+  std::vector< std::vector<lno_t> > adj (V);
+  for(lno_t v = 0; v + 3 < V - 1; v++)
+  {
+    adj[v].push_back(v + 3);
+    if (v % 3 == 2 && v + 6 < V - 1)
+      adj[v].push_back(v + 6);
+  }
+  adj[297].push_back(0);
+
+  pairg::matrixOps::lno_view_t row_map ("row_map", V + 1);
+  std::vector<lno_t> cols;
+  for(lno_t v = 0; v < V; v++)
+  {
+    std::sort(adj[v].begin(), adj[v].end());
+    cols.insert(cols.end(), adj[v].begin(), adj[v].end());
+    row_map(v + 1) = cols.size();
+  }
+
+  pairg::matrixOps::lno_nnz_view_t entries ("entries", cols.size());
+  std::copy(cols.begin(), cols.end(), entries.data());
+  pairg::matrixOps::graph_t A (entries, row_map);
+
+  pairg::Parameters parameters;
+  parameters.d_low = 2;
+  parameters.d_up = 7;
+
+  pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters);
+
+  //blocks sized to a budget of about 100 vertices, from the sampled row size
+  double bytesPerVertex = 3 * ((double) B.entries.extent(0) / V * sizeof(lno_t) + sizeof(pairg::matrixOps::size_type));
+  lno_t budgeted = pairg::componentIndex::blockVerticesFor(A, parameters, (std::size_t) (100 * bytesPerVertex));
+  REQUIRE(budgeted >= 50);
+  REQUIRE(budgeted <= 200);
+
+  //one block per component, blocks within the budget, and all components in one block
+  for(lno_t blockVertices : {(lno_t) 1, budgeted, (lno_t) (1 << 16)})
+  {
+    pairg::componentIndex index;
+    index.build(A, parameters, blockVertices);
+
+    REQUIRE(index.numComponents == 4);
+    if (blockVertices == 1)
+      REQUIRE(index.blocks.size() == 4);
+    else if (blockVertices == budgeted)
+      REQUIRE(index.blocks.size() >= 2);
+    else
+      REQUIRE(index.blocks.size() == 1);
+
+    for(lno_t i = 0; i < V; i++)
+      for(lno_t j = 0; j < V; j++)
+        REQUIRE(index.queryValue(i, j) == pairg::matrixOps::queryValue(B, i, j));
+
+    //blocks are moved into the global pattern
+    pairg::matrixOps::graph_t G = index.toGlobal();
+    REQUIRE(index.blocks.empty());
+    REQUIRE(index.numRows == 0);
+    REQUIRE(G.entries.extent(0) == B.entries.extent(0));
+    REQUIRE(std::equal(B.row_map.data(), B.row_map.data() + V + 1, G.row_map.data()));
+    REQUIRE(std::equal(B.entries.data(), B.entries.data() + B.entries.extent(0), G.entries.data()));
+  }
+
+  Kokkos::finalize();
+}
+
+TEST_CASE("topological sweep on a wide acyclic graph") 
+{
+  Kokkos::initialize();
+
+  typedef pairg::matrixOps::lno_t lno_t;
+
+  //12 layers of 150 vertices, each vertex has 3 successors in the next layer,
+  //so every wavefront of the sweep is a whole layer, wide enough to run in parallel
+  const lno_t L = 12, W = 150, V = L * W;
+  pairg::matrixOps::lno_view_t row_map ("row_map", V + 1);
+  std::vector<lno_t> cols;
+  for(lno_t v = 0; v < V; v++)
+  {
+    lno_t l = v / W, x = v % W;
+    if (l + 1 < L)
+    {
+      std::vector<lno_t> succ = {(l + 1) * W + x, (l + 1) * W + (x * 7 + 3) % W, (l + 1) * W + (x + 1) % W};
+      std::sort(succ.begin(), succ.end());
+      succ.erase(std::unique(succ.begin(), succ.end()), succ.end());
+      cols.insert(cols.end(), succ.begin(), succ.end());
+    }
+    row_map(v + 1) = cols.size();
+  }
+
+  pairg::matrixOps::lno_nnz_view_t entries ("entries", cols.size());
+  std::copy(cols.begin(), cols.end(), entries.data());
+  pairg::matrixOps::graph_t A (entries, row_map);
+  REQUIRE(pairg::matrixOps::isUpperTriangular(A));
+
+  std::vector< std::pair<int,int> > windows = {{0, 3}, {2, 7}, {4, 11}, {5, 5}, {0, 64}};
+
+  std::vector<pairg::matrixOps::graph_t> expected;
+  for(auto &w : windows)
+  {
+    pairg::Parameters parameters;
+    std::tie(parameters.d_low, parameters.d_up) = w;
+
+    pairg::matrixOps::graph_t C, D;
+    pairg::buildValidPairsFactors(A, parameters, C, D);
+    pairg::matrixOps::graph_t E = pairg::matrixOps::multiplyFactors(C, D);
+    pairg::matrixOps::graph_t S = pairg::buildValidPairsGraphDAG(A, parameters);
+
+    REQUIRE(S.entries.extent(0) == E.entries.extent(0));
+    REQUIRE(std::equal(S.row_map.data(), S.row_map.data() + V + 1, E.row_map.data()));
+    REQUIRE(std::equal(S.entries.data(), S.entries.data() + S.entries.extent(0), E.entries.data()));
+    expected.push_back(E);
+  }
+
+  //several windows at once, each by sweep or by powers
+  pairg::buildValidPairsGraphs(A, windows, [&](std::size_t k, const pairg::matrixOps::graph_t &B)
+  {
+    REQUIRE(B.entries.extent(0) == expected[k].entries.extent(0));
+    REQUIRE(std::equal(B.entries.data(), B.entries.data() + B.entries.extent(0), expected[k].entries.data()));
+  });
+
+  Kokkos::finalize();
+}
+
+TEST_CASE("row filter on rows with gaps") 
+{
+  Kokkos::initialize();
+
+  int V = 2000;
+
+  //row 0: {0, 1000}, row 1: {5, 6, ..., 68}, row 2: {100, 101, 1999}, remaining rows empty
+  std::vector< std::vector<int> > rows = {{0, 1000}, {}, {100, 101, 1999}};
+  for(int c = 5; c <= 68; c++)
+    rows[1].push_back(c);
+
+  pairg::matrixOps::lno_view_t row_map ("row_map", V + 1);
+  std::vector<int> cols;
+  for(int i = 0; i < V; i++)
+  {
+    if (i < (int) rows.size())
+      cols.insert(cols.end(), rows[i].begin(), rows[i].end());
+    row_map(i + 1) = cols.size();
+  }
+
+  pairg::matrixOps::lno_nnz_view_t entries ("entries", cols.size());
+  std::copy(cols.begin(), cols.end(), entries.data());
+  pairg::matrixOps::graph_t G (entries, row_map);
+
+  pairg::rowFilter filter;
+  filter.build(G);
+
+  //no false negatives, anywhere
+  for(int i = 0; i < 4; i++)
+    for(int j = 0; j < V; j++)
+      if (pairg::matrixOps::queryValue(G, i, j))
+        REQUIRE(filter.mayContain(i, j));
+
+  //row 0: blocks of width 16 starting at column 0
+  REQUIRE(filter.mayContain(0, 15) == true);
+  REQUIRE(filter.mayContain(0, 16) == false);
+  REQUIRE(filter.mayContain(0, 500) == false);
+  REQUIRE(filter.mayContain(0, 1001) == false);
+
+  //row 1: 64 consecutive columns, one per block, exact
+  for(int j = 0; j < 100; j++)
+    REQUIRE(filter.mayContain(1, j) == (j >= 5 && j <= 68));
+
+  //row 2: blocks of width 32 starting at column 100
+  REQUIRE(filter.mayContain(2, 99) == false);
+  REQUIRE(filter.mayContain(2, 131) == true);
+  REQUIRE(filter.mayContain(2, 132) == false);
+  REQUIRE(filter.mayContain(2, 1000) == false);
+  REQUIRE(filter.mayContain(2, 1999) == true);
+
+  REQUIRE(filter.mayContain(3, 0) == false);
+
+  Kokkos::finalize();
+}
+
+
+TEST_CASE("compressed rows with wide column gaps") 
+{
+  Kokkos::initialize();
+
+  typedef pairg::matrixOps::lno_t lno_t;
+
+  //rows with 0, 1, 4, 64, 65 and 300 columns, gaps spanning 1 to 4 bytes
+  std::vector<int> counts = {0, 1, 4, 64, 65, 300};
+  std::vector<lno_t> gaps = {1, 2, 255, 256, 65535, 65536, 1 << 20, (1 << 24) + 7};
+
+  pairg::matrixOps::lno_view_t row_map ("row_map", counts.size() + 1);
+  std::vector<lno_t> cols;
+  for(std::size_t i = 0; i < counts.size(); i++)
+  {
+    lno_t c = i;
+    for(int k = 0; k < counts[i]; k++)
+    {
+      cols.push_back(c);
+      c += gaps[(k * 7 + i) % gaps.size()];
+    }
+    row_map(i + 1) = cols.size();
+  }
+
+  pairg::matrixOps::lno_nnz_view_t entries ("entries", cols.size());
+  std::copy(cols.begin(), cols.end(), entries.data());
+
+  pairg::matrixOps::graph_t G (entries, row_map);
+
+  //column ids exceed the count of rows here
+  pairg::compressedIndex index;
+  index.build(G, cols.back() + 2);
+
+  REQUIRE(index.block_first.extent(0) == 0 + 1 + 1 + 1 + 2 + 5);
+
+  for(std::size_t i = 0; i < counts.size(); i++)
+  {
+    std::vector<lno_t> row;
+    index.decodeRow(i, row);
+    REQUIRE(std::equal(row.begin(), row.end(), cols.data() + row_map(i)));
+    REQUIRE(row.size() == counts[i]);
+
+    for(pairg::matrixOps::size_type k = row_map(i); k < row_map(i+1); k++)
+    {
+      REQUIRE(index.queryValue(i, cols[k]) == true);
+      REQUIRE(index.queryValue(i, cols[k] + 1) == (k + 1 < row_map(i+1) && cols[k+1] == cols[k] + 1));
+    }
+
+    REQUIRE(index.queryValue(i, 0) == (counts[i] > 0 && cols[row_map(i)] == 0));
+  }
+
+  Kokkos::finalize();
+}
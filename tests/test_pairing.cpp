@@ -198,5 +198,144 @@ TEST_CASE("building valid-pair matrix for a chain graph")
     }
   }
 
+  SECTION( "distance limits are 100, 110, sparsity pattern only" )
+  {
+    char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", "100", "-u", "110", "-t", "4", "-c", "0", nullptr};
+    int argc = 13;
+
+    pairg::Parameters parameters;        
+    pairg::parseandSave(argc, argv, parameters);
+
+    int V = 81189;
+
+    pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+    pairg::matrixOps::graph_t B = pairg::buildValidPairsGraph(A, parameters); 
+
+    int NNZ = 891924;
+
+    SECTION( "evaluating pattern size" ) {
+      REQUIRE(B.numRows() == V);  
+      REQUIRE(B.row_map.extent(0) == V + 1); 
+      REQUIRE(B.entries.extent(0) == NNZ); 
+    }
+
+    SECTION( "evaluating powers of adjacency pattern" ) {
+      //on a chain, A^n has exactly one entry (i, i+n) per row i < V-n
+      for(int n = 0; n <= 9; n++)
+      {
+        pairg::matrixOps::graph_t P = pairg::matrixOps::power(A, n);
+        REQUIRE(P.entries.extent(0) == V - n); 
+        REQUIRE(pairg::matrixOps::queryValue (P, 5, 5 + n) == true);
+      }
+    }
+
+    SECTION( "checking whether queries are answered correctly" ) {
+      REQUIRE(pairg::matrixOps::queryValue (B, 0, 99) == false);
+      REQUIRE(pairg::matrixOps::queryValue (B, 0, 100) == true);
+      REQUIRE(pairg::matrixOps::queryValue (B, 0, 110) == true);
+      REQUIRE(pairg::matrixOps::queryValue (B, 0, 111) == false);
+
+      REQUIRE(pairg::matrixOps::queryValue (B, 81078, 81188) == true);
+      REQUIRE(pairg::matrixOps::queryValue (B, 81077, 81188) == false);
+    }
+  }
+
+  SECTION( "several distance windows with one build" )
+  {
+    char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", "100", "-u", "110", "-t", "4", "-c", "0", "-w", "0:50", "300:420", "100:110", nullptr};
+    int argc = 17;
+
+    pairg::Parameters parameters;        
+    pairg::parseandSave(argc, argv, parameters);
+
+    REQUIRE(parameters.windows.size() == 4);
+    REQUIRE(parameters.windows[0] == std::make_pair(100, 110));
+    REQUIRE(parameters.windows[2] == std::make_pair(300, 420));
+
+    pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+
+    int visited = 0;
+    pairg::buildValidPairsGraphs(A, parameters.windows, [&](std::size_t k, const pairg::matrixOps::graph_t &B)
+    {
+      //same pattern as a separate build for the window
+      pairg::Parameters window = parameters;
+      std::tie(window.d_low, window.d_up) = parameters.windows[k];
+      pairg::matrixOps::graph_t E = pairg::buildValidPairsGraph(A, window); 
+
+      REQUIRE(B.entries.extent(0) == E.entries.extent(0));
+      REQUIRE(std::equal(B.row_map.data(), B.row_map.data() + B.row_map.extent(0), E.row_map.data()));
+      REQUIRE(std::equal(B.entries.data(), B.entries.data() + B.entries.extent(0), E.entries.data()));
+      visited++;
+    });
+
+    REQUIRE(visited == 4);
+  }
+
+  SECTION( "power-of-two window lengths skip the final multiplication" )
+  {
+    char *argv[] = {"pairmap2graph", "-m", "txt", "-r", RFILE.data(), "-l", "0", "-u", "64", "-t", "4", "-c", "0", nullptr};
+    int argc = 13;
+
+    pairg::Parameters parameters;        
+    pairg::parseandSave(argc, argv, parameters);
+
+    int V = 81189;
+
+    pairg::matrixOps::graph_t A = pairg::getAdjacencyGraph(parameters);
+    pairg::matrixOps::graph_t AI = pairg::matrixOps::addGraphs(A, pairg::matrixOps::createIdentityGraph(V));
+
+    //(A+I)^64 and A^64 cost six squarings each, no accumulation, no final product
+    {
+      std::vector<pairg::matrixOps::powerTerm> terms = {pairg::matrixOps::powerTerm(A, 0), pairg::matrixOps::powerTerm(AI, 64)};
+      pairg::matrixOps::graph_t C, D;
+      REQUIRE(pairg::matrixOps::powerFactors(terms, V, C, D) == 6);
+      REQUIRE(pairg::matrixOps::missingFactor(D));
+      REQUIRE(pairg::matrixOps::multiplyFactors(C, D).entries.extent(0) == 65 * V - 64 * 65 / 2);
+    }
+    {
+      std::vector<pairg::matrixOps::powerTerm> terms = {pairg::matrixOps::powerTerm(A, 64), pairg::matrixOps::powerTerm(AI, 0)};
+      pairg::matrixOps::graph_t C, D;
+      REQUIRE(pairg::matrixOps::powerFactors(terms, V, C, D) == 6);
+      REQUIRE(pairg::matrixOps::missingFactor(D));
+      REQUIRE(pairg::matrixOps::multiplyFactors(C, D).entries.extent(0) == V - 64);
+    }
+
+    //two factors left, A^3 = A * A^2 is the only accumulation
+    {
+      std::vector<pairg::matrixOps::powerTerm> terms = {pairg::matrixOps::powerTerm(A, 3), pairg::matrixOps::powerTerm(AI, 64)};
+      pairg::matrixOps::graph_t C, D;
+      REQUIRE(pairg::matrixOps::powerFactors(terms, V, C, D) == 8);
+      REQUIRE(!pairg::matrixOps::missingFactor(D));
+    }
+
+    //same with squarings shared across windows
+    {
+      pairg::matrixOps::squareCache powAI (AI);
+      std::vector< std::pair<pairg::matrixOps::squareCache*, int> > terms = {{&powAI, 64}};
+      pairg::matrixOps::graph_t C, D;
+      REQUIRE(pairg::matrixOps::powerFactors(terms, V, C, D) == 0);
+      REQUIRE(powAI.spgemm_calls == 6);
+      REQUIRE(pairg::matrixOps::missingFactor(D));
+
+      //squares no remaining window needs are released, the last one is kept
+      REQUIRE(powAI.heldSquares() == 7);
+      powAI.release(3);
+      REQUIRE(powAI.heldSquares() == 3);
+      terms = {{&powAI, 3}};
+      REQUIRE(pairg::matrixOps::powerFactors(terms, V, C, D) == 0);
+      REQUIRE(pairg::matrixOps::multiplyFactors(C, D).entries.extent(0) == 4 * V - 3 * 4 / 2);
+      powAI.release(0);
+      REQUIRE(powAI.heldSquares() == 1);
+    }
+
+    //no factor at all
+    {
+      std::vector<pairg::matrixOps::powerTerm> terms = {pairg::matrixOps::powerTerm(A, 0), pairg::matrixOps::powerTerm(AI, 0)};
+      pairg::matrixOps::graph_t C, D;
+      REQUIRE(pairg::matrixOps::powerFactors(terms, V, C, D) == 0);
+      REQUIRE(pairg::matrixOps::multiplyFactors(C, D).entries.extent(0) == V);
+    }
+  }
+
   Kokkos::finalize();
 }